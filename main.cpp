@@ -21,6 +21,28 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+// SIMD指令集（雨滴批量积分）
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RAIN_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define RAIN_SIMD_X86 0
+#endif
 
 #ifdef _WIN32
 #include <windows.h>
@@ -78,6 +100,116 @@ const int CLOUD_COUNT = 4;        // 云朵数量
 const float MOON_SIZE = 20.0f;    // 月亮大小
 const float MOON_X = 70.0f;       // 月亮X坐标
 const float MOON_Y = 60.0f;       // 月亮Y坐标
+const int RAINDROP_POOL_CAPACITY = 1 << 17; // 雨滴池容量（暴雨场景可提高到 1 << 20）
+const int RAINDROP_JOB_CHUNK = 4096;        // 并行更新时每个任务处理的雨滴数
+const int RIPPLE_POOL_CAPACITY = 8192;      // 涟漪池容量（网格上限 16 × 400 格之内）
+const int RIPPLE_JOB_CHUNK = 256;           // 并行更新时每个任务处理的涟漪数
+const int TIMER_TICKS_PER_SECOND = 1000;    // 调度器刻度（模拟时间毫秒）
+const int RIPPLE_TILE_RESOLUTION = 32;      // 解析涟漪着色的分块数（每边），每个片元只检查所在块的涟漪
+const float RIPPLE_AGGREGATE_DECAY = 4.0f;  // 远处聚合涟漪场的衰减时间常数（秒），与单个涟漪的平均寿命相当
+const float RIPPLE_AGGREGATE_SATURATION = 6.0f; // 聚合强度 1 - exp(-能量 / 饱和值)
+const int RIPPLE_GRID_RESOLUTION = 20;      // 涟漪网格每边的格子数（格子边长 POND_SIZE / 20）
+const float RIPPLE_MERGE_AGE = 0.25f;       // 撞击点附近存在比这更年轻的涟漪时并入它，不再生成新涟漪（秒）
+const int CLIPMAP_GRID = 32;                // 水面 clipmap 每层每边的格数（须为 4 的倍数）
+const int CLIPMAP_LEVELS = 5;               // 层数，第 L 层格距为 CLIPMAP_BASE_CELL * 2^L
+const float WATER_WAVE_SPEED = 1.8f;        // 叠加正弦波的时间倍率（water.vert 的 waveSpeed，波形图集按它烘焙）
+const float CLIPMAP_BASE_CELL = 2.0f;       // 最内层格距（世界单位）；最外层覆盖 ±512，与旧的 64×64 均匀网格三角形数相同
+const int GPU_RAINDROP_CAPACITY = 1 << 21;  // GPU模拟的雨滴上限（首次启用时分配显存）
+const int MAX_SIM_STEPS_PER_FRAME = 8;      // 每帧最多追赶的模拟步数，超出的时间直接丢弃
+const float RAIN_DROPS_PER_DENSITY = 20.0f; // 雨滴密度 1 对应的每秒生成数
+const int FAR_UPDATE_STRIDE = 3;            // 远层雨滴每隔几步积分一次
+const int MID_TRAIL_LENGTH = 4;             // 中层雨滴最多绘制的拖尾记录数
+const float LOD_HYSTERESIS = 0.02f;         // 远层雨滴回到近层所需的额外深度差，避免来回切换
+const float RAINDROP_CULL_RADIUS = 2.0f;     // 视锥剔除时远层雨滴（只绘制点）的包围球半径
+const float TRAIL_CULL_RADIUS = 16.0f;       // 近/中层雨滴的包围球半径，覆盖向上延伸的拖尾
+
+// 雨滴细节层次（按 layerDepth 划分）
+enum RaindropLod {
+    LOD_NEAR = 0,   // 完整拖尾和摆动，每步积分
+    LOD_MID,        // 拖尾缩短
+    LOD_FAR,        // 只绘制点：没有拖尾和摆动，降低积分频率
+    LOD_TIER_COUNT
+};
+
+// 透明物体（雨滴、拖尾、涟漪、闪电）的混合方式
+enum TransparencyMode {
+    TRANSPARENCY_SORTED = 0,      // 按距离排序后依次混合
+    TRANSPARENCY_WEIGHTED_OIT     // 加权混合顺序无关透明度，任意顺序绘制
+};
+
+// 涟漪的绘制方式
+enum RippleShadingMode {
+    RIPPLE_SHADING_GEOMETRY = 0,  // 实例化环形网格，加法混合叠加在水面上
+    RIPPLE_SHADING_ANALYTIC       // 水面片元着色器按分块列表逐个计算环纹，不绘制涟漪几何
+};
+
+// 基于计数器的随机数生成器（SplitMix64 混合函数）
+// 第 n 个数 = mix(流密钥 + n * 常数)，没有隐藏的全局状态：同一种子和流编号总是得到相同序列。
+// 每个子系统、每个并行任务各用一个流，生成顺序和线程数都不会影响彼此的结果。
+class CounterRng {
+public:
+    explicit CounterRng(uint64_t seed = 0, uint64_t stream = 0) :
+        key(mix(mix(seed) + stream * STREAM_STEP)),
+        counter(0) {
+    }
+
+    // 派生子流（例如按任务块编号），与父流的消耗进度无关
+    CounterRng split(uint64_t stream) const {
+        return CounterRng(key, stream);
+    }
+
+    uint64_t nextU64() {
+        return mix(key + ++counter * COUNTER_STEP);
+    }
+
+    uint32_t nextU32() {
+        return static_cast<uint32_t>(nextU64() >> 32);
+    }
+
+    // [0, 1) 均匀分布，24位精度
+    float uniform() {
+        return static_cast<float>(nextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // [0, n) 均匀分布整数
+    int nextInt(int n) {
+        return static_cast<int>((static_cast<uint64_t>(nextU32()) * static_cast<uint32_t>(n)) >> 32);
+    }
+
+    // 批量生成 n 个 [0, 1) 浮点数，结果与连续调用 uniform() 相同；各元素互不依赖，循环可向量化
+    void fillUniform(float* out, int n) {
+        uint64_t base = counter;
+        for (int k = 0; k < n; k++) {
+            out[k] = static_cast<float>(mix(key + (base + k + 1) * COUNTER_STEP) >> 40) * (1.0f / 16777216.0f);
+        }
+        counter += n;
+    }
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static const uint64_t COUNTER_STEP = 0x9E3779B97F4A7C15ull;
+    static const uint64_t STREAM_STEP = 0xD1B54A32D192ED03ull;
+
+    uint64_t key;
+    uint64_t counter;
+};
+
+// 场景种子派生出的随机数流，各子系统互不干扰（例如关闭声音不会改变雨滴序列）
+enum RngStream {
+    RNG_STREAM_SPAWN = 0,   // 雨滴生成
+    RNG_STREAM_RIPPLE,      // 涟漪参数
+    RNG_STREAM_LIGHTNING,   // 闪电
+    RNG_STREAM_AUDIO,       // 声音音量变化
+    RNG_STREAM_SCENERY,     // 星星和云朵
+    RNG_STREAM_TEXTURE,     // 默认纹理
+    RNG_STREAM_GPU,         // GPU雨滴模拟的哈希种子
+    RNG_STREAM_OCEAN        // FFT 海浪的初始谱
+};
 
 // 星星结构
 struct Star {
@@ -105,6 +237,7 @@ struct Lightning {
     float thickness;
     bool active;
     int branches;  // 分支数量
+    int id;        // 调度器中的稳定编号
     
     Lightning() : 
         color(0.9f, 0.9f, 1.0f),
@@ -113,14 +246,15 @@ struct Lightning {
         currentTime(0.0f),
         thickness(2.0f),
         active(false),
-        branches(0) {}
+        branches(0),
+        id(-1) {}
         
-    void generate(const glm::vec3& start, const glm::vec3& end) {
+    void generate(const glm::vec3& start, const glm::vec3& end, CounterRng& rng) {
         segments.clear();
         segments.reserve(15); // 预分配内存提高性能
         
         // 主路径
-        int numSegments = 8 + rand() % 6;  // 8-13个段
+        int numSegments = 8 + rng.nextInt(6);  // 8-13个段
         for (int i = 0; i <= numSegments; i++) {
             float t = float(i) / numSegments;
             
@@ -130,9 +264,9 @@ struct Lightning {
             // 添加随机偏移创造锯齿效果
             if (i > 0 && i < numSegments) {
                 float maxOffset = 15.0f * (1.0f - abs(t - 0.5f) * 2.0f);  // 中间偏移更大
-                point.x += (static_cast<float>(rand()) / RAND_MAX - 0.5f) * maxOffset;
-                point.z += (static_cast<float>(rand()) / RAND_MAX - 0.5f) * maxOffset;
-                point.y += (static_cast<float>(rand()) / RAND_MAX - 0.5f) * maxOffset * 0.5f;
+                point.x += (rng.uniform() - 0.5f) * maxOffset;
+                point.z += (rng.uniform() - 0.5f) * maxOffset;
+                point.y += (rng.uniform() - 0.5f) * maxOffset * 0.5f;
             }
             
             segments.push_back(point);
@@ -140,35 +274,54 @@ struct Lightning {
         
         // 随机颜色变化
         color = glm::vec3(
-            0.7f + static_cast<float>(rand()) / RAND_MAX * 0.3f,  // R: 0.7-1.0
-            0.8f + static_cast<float>(rand()) / RAND_MAX * 0.2f,  // G: 0.8-1.0  
-            0.9f + static_cast<float>(rand()) / RAND_MAX * 0.1f   // B: 0.9-1.0
+            0.7f + rng.uniform() * 0.3f,  // R: 0.7-1.0
+            0.8f + rng.uniform() * 0.2f,  // G: 0.8-1.0  
+            0.9f + rng.uniform() * 0.1f   // B: 0.9-1.0
         );
         
-        intensity = 0.8f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
-        duration = 1.0f + static_cast<float>(rand()) / RAND_MAX * 2.0f; // 延长持续时间
-        thickness = 1.5f + static_cast<float>(rand()) / RAND_MAX * 2.0f;
-        branches = rand() % 3;  // 0-2个分支
+        intensity = 0.8f + rng.uniform() * 0.4f;
+        duration = 1.0f + rng.uniform() * 2.0f; // 延长持续时间
+        thickness = 1.5f + rng.uniform() * 2.0f;
+        branches = rng.nextInt(3);  // 0-2个分支
         
         currentTime = 0.0f;
         active = true;
     }
     
-    bool update(float deltaTime) {
-        if (!active) return false;
+    // 到达 duration 后由调度器删除
+    void update(float deltaTime) {
+        if (!active) return;
         
         currentTime += deltaTime;
         
         // 强度衰减
-        float progress = currentTime / duration;
+        float progress = std::min(currentTime / duration, 1.0f);
         intensity = (1.0f - progress) * (0.8f + 0.2f * sin(currentTime * 50.0f));
-        
-        if (currentTime >= duration) {
-            active = false;
-            return false; // 返回false表示应该删除
-        }
-        
-        return true; // 返回true表示继续保持
+    }
+};
+
+// uniform 名称的 FNV-1a 哈希；按名称设置时每次调用都在运行时计算，之后在已排序的槽索引中二分查找
+inline uint64_t uniformHash(const char* name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (; *name; name++) {
+        hash = (hash ^ static_cast<uint8_t>(*name)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// 类型化的 uniform 句柄：由 Shader::uniform<T>() 解析一次，设置值时不再构造字符串或查询位置。
+// 程序中没有（或被编译器优化掉）的 uniform、或 T 与着色器中声明的类型不符时得到无效句柄，设置时直接忽略
+template <typename T>
+struct UniformHandle {
+    int slot;
+    int count;   // 数组元素数（非数组为 1）
+
+    UniformHandle() : slot(-1), count(0) {}
+    UniformHandle(int _slot, int _count) : slot(_slot), count(_count) {}
+
+    // 数组元素；越界得到无效句柄
+    UniformHandle operator[](int i) const {
+        return i >= 0 && i < count ? UniformHandle(slot + i, 1) : UniformHandle();
     }
 };
 
@@ -177,94 +330,52 @@ class Shader {
 public:
     unsigned int ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        // 1. 从文件读取顶点和片段着色器源代码
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
+    Shader(const char* vertexPath, const char* fragmentPath)
+        : Shader(vertexPath, nullptr, fragmentPath, {}) {
+    }
 
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        
-        try {
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            
-            std::stringstream vShaderStream, fShaderStream;
-            
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            
-            vShaderFile.close();
-            fShaderFile.close();
-            
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch(std::ifstream::failure& e) {
-            std::cout << "错误::着色器::文件读取失败: " << e.what() << std::endl;
-            
-            // 如果构建目录失败，尝试在项目根目录查找文件
-            try {
-                // 尝试向上一级目录查找
-                std::string projectRootVertPath = std::string("../") + vertexPath;
-                std::string projectRootFragPath = std::string("../") + fragmentPath;
-                
-                vShaderFile.open(projectRootVertPath);
-                fShaderFile.open(projectRootFragPath);
-                
-                std::stringstream vShaderStream, fShaderStream;
-                
-                vShaderStream << vShaderFile.rdbuf();
-                fShaderStream << fShaderFile.rdbuf();
-                
-                vShaderFile.close();
-                fShaderFile.close();
-                
-                vertexCode = vShaderStream.str();
-                fragmentCode = fShaderStream.str();
-                
-                std::cout << "成功从项目根目录加载着色器" << std::endl;
-            }
-            catch(std::ifstream::failure& e2) {
-                std::cerr << "错误: 从构建目录和项目目录都无法读取着色器文件" << std::endl;
-                
-                // 如果无法加载文件，使用硬编码着色器
-                // 这将在writeShaderFiles()函数中处理
-            }
-        }
-        
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+    // 完整形式：几何着色器可选；fragmentPath 为空时程序只用于变换反馈（需配合 GL_RASTERIZER_DISCARD）
+    Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath,
+           const std::vector<const char*>& feedbackVaryings) {
+        // 1. 从文件读取着色器源代码
+        std::string vertexCode = readSource(vertexPath);
         
         // 2. 编译着色器
-        unsigned int vertex, fragment;
-        int success;
-        char infoLog[512];
+        unsigned int vertex, geometry = 0, fragment = 0;
         
         // 顶点着色器
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+        vertex = compile(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+        
+        // 几何着色器
+        if (geometryPath) {
+            geometry = compile(GL_GEOMETRY_SHADER, readSource(geometryPath), "GEOMETRY");
+        }
         
         // 片段着色器
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        if (fragmentPath) {
+            fragment = compile(GL_FRAGMENT_SHADER, readSource(fragmentPath), "FRAGMENT");
+        }
         
         // 着色器程序
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
+        if (geometry) glAttachShader(ID, geometry);
+        if (fragment) glAttachShader(ID, fragment);
+        
+        // 变换反馈输出必须在链接前声明
+        if (!feedbackVaryings.empty()) {
+            glTransformFeedbackVaryings(ID, static_cast<int>(feedbackVaryings.size()),
+                                        feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+        }
+        
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        enumerateUniforms();
         
         // 删除着色器 - 它们已链接到程序中，不再需要
         glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        if (geometry) glDeleteShader(geometry);
+        if (fragment) glDeleteShader(fragment);
     }
 
     // 激活着色器
@@ -272,246 +383,2507 @@ public:
         glUseProgram(ID);
     }
 
-    // Uniform工具函数
-    void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    // 按名称解析类型化句柄（通常在着色器加载后解析一次并保存）；数组名或 name[0] 得到覆盖整个数组的句柄。
+    // T 与链接后报告的类型不符时返回无效句柄（调试构建中断言）
+    template <typename T>
+    UniformHandle<T> uniform(const char* name) const {
+        int slot = findSlot(uniformHash(name));
+        if (slot < 0) return UniformHandle<T>();
+        bool typeMatches = accepts(uniformSlots[slot].type, static_cast<const T*>(nullptr));
+        assert(typeMatches && "uniform type mismatch");
+        if (!typeMatches) return UniformHandle<T>();
+        return UniformHandle<T>(slot, uniformSlots[slot].count);
+    }
+
+    // 通过句柄设置：值与上次设置的相同时跳过上传
+    template <typename T>
+    void set(UniformHandle<T> handle, const typename std::common_type<T>::type& value) {
+        store(handle.slot, value);
+    }
+    void set(UniformHandle<bool> handle, bool value) {
+        store(handle.slot, static_cast<int>(value));
+    }
+
+    // Uniform工具函数：每次调用哈希名称并二分查找已枚举的位置，不构造 std::string，也不查询驱动；
+    // 每帧多次设置的 uniform（逐星星、逐闪电段）应改用加载时解析的句柄
+    void setBool(const char* name, bool value) { set(uniform<bool>(name), value); }
+    void setInt(const char* name, int value) { set(uniform<int>(name), value); }
+    void setUint(const char* name, unsigned int value) { set(uniform<unsigned int>(name), value); }
+    void setFloat(const char* name, float value) { set(uniform<float>(name), value); }
+    void setVec2(const char* name, const glm::vec2& value) { set(uniform<glm::vec2>(name), value); }
+    void setVec3(const char* name, const glm::vec3& value) { set(uniform<glm::vec3>(name), value); }
+    void setVec4(const char* name, const glm::vec4& value) { set(uniform<glm::vec4>(name), value); }
+    void setMat2(const char* name, const glm::mat2& mat) { set(uniform<glm::mat2>(name), mat); }
+    void setMat3(const char* name, const glm::mat3& mat) { set(uniform<glm::mat3>(name), mat); }
+    void setMat4(const char* name, const glm::mat4& mat) { set(uniform<glm::mat4>(name), mat); }
+    // 运行时拼接的名称
+    void setBool(const std::string &name, bool value) { setBool(name.c_str(), value); }
+    void setInt(const std::string &name, int value) { setInt(name.c_str(), value); }
+    void setFloat(const std::string &name, float value) { setFloat(name.c_str(), value); }
+    void setVec3(const std::string &name, const glm::vec3 &value) { setVec3(name.c_str(), value); }
+    void setMat4(const std::string &name, const glm::mat4 &mat) { setMat4(name.c_str(), mat); }
+
+    // 所有程序累计的 glUniform* 调用数和因值未变而跳过的次数（每帧由调用方清零）
+    static inline int uploadCount = 0;
+    static inline int skippedCount = 0;
+
+private:
+    // 链接后枚举的活动 uniform，数组按元素展开为连续的槽
+    struct UniformSlot {
+        int location;
+        GLenum type;        // glGetActiveUniform 报告的类型
+        int count;          // 从本元素到数组末尾的元素数
+        bool known;         // 影子值有效
+        float value[16];    // 上次上传的值（最大为 mat4）
+    };
+    std::vector<UniformSlot> uniformSlots;
+    std::vector<std::pair<uint64_t, int>> uniformIndex; // (名称哈希, 槽)，按哈希排序
+
+    void enumerateUniforms() {
+        int activeCount = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &activeCount);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> buffer(std::max(maxLength, 1));
+        for (int u = 0; u < activeCount; u++) {
+            GLint size = 0;
+            GLenum type = 0;
+            GLsizei length = 0;
+            glGetActiveUniform(ID, u, static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            
+            // 数组报告为 name[0]：基本名和每个元素都登记，元素占用连续的槽
+            bool isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+            std::string base = isArray ? name.substr(0, name.size() - 3) : name;
+            int first = static_cast<int>(uniformSlots.size());
+            for (int i = 0; i < size; i++) {
+                std::string element = isArray ? base + "[" + std::to_string(i) + "]" : name;
+                UniformSlot slot = {};
+                slot.location = glGetUniformLocation(ID, element.c_str());
+                slot.type = type;
+                slot.count = size - i;
+                uniformSlots.push_back(slot);
+                uniformIndex.emplace_back(uniformHash(element.c_str()), first + i);
+            }
+            if (isArray) uniformIndex.emplace_back(uniformHash(base.c_str()), first);
+        }
+        std::sort(uniformIndex.begin(), uniformIndex.end());
+    }
+
+    int findSlot(uint64_t hash) const {
+        auto it = std::lower_bound(uniformIndex.begin(), uniformIndex.end(), std::make_pair(hash, -1));
+        return it != uniformIndex.end() && it->first == hash ? it->second : -1;
+    }
+
+    template <typename V>
+    void store(int slotIndex, const V& value) {
+        static_assert(sizeof(V) <= sizeof(UniformSlot::value), "uniform value too large");
+        if (slotIndex < 0) return;
+        UniformSlot& slot = uniformSlots[slotIndex];
+        if (slot.known && std::memcmp(slot.value, &value, sizeof(V)) == 0) {
+            skippedCount++;
+            return;
+        }
+        std::memcpy(slot.value, &value, sizeof(V));
+        slot.known = true;
+        upload(slot.location, value);
+        uploadCount++;
+    }
+
+    // 句柄类型可以设置的 GL 类型，按 glUniform* 的规则：bool 可用整数或浮点设置，采样器用整数设置
+    static bool isSampler(GLenum type) {
+        switch (type) {
+            case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_2D_MULTISAMPLE:
+            case GL_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_BUFFER:
+            case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+                return true;
+            default:
+                return false;
+        }
+    }
+    static bool accepts(GLenum type, const bool*) { return type == GL_BOOL || type == GL_INT; }
+    static bool accepts(GLenum type, const int*) { return type == GL_INT || type == GL_BOOL || isSampler(type); }
+    static bool accepts(GLenum type, const unsigned int*) { return type == GL_UNSIGNED_INT || type == GL_BOOL; }
+    static bool accepts(GLenum type, const float*) { return type == GL_FLOAT || type == GL_BOOL; }
+    static bool accepts(GLenum type, const glm::vec2*) { return type == GL_FLOAT_VEC2; }
+    static bool accepts(GLenum type, const glm::vec3*) { return type == GL_FLOAT_VEC3; }
+    static bool accepts(GLenum type, const glm::vec4*) { return type == GL_FLOAT_VEC4; }
+    static bool accepts(GLenum type, const glm::mat2*) { return type == GL_FLOAT_MAT2; }
+    static bool accepts(GLenum type, const glm::mat3*) { return type == GL_FLOAT_MAT3; }
+    static bool accepts(GLenum type, const glm::mat4*) { return type == GL_FLOAT_MAT4; }
+
+    static void upload(int location, int value) { glUniform1i(location, value); }
+    static void upload(int location, unsigned int value) { glUniform1ui(location, value); }
+    static void upload(int location, float value) { glUniform1f(location, value); }
+    static void upload(int location, const glm::vec2& value) { glUniform2fv(location, 1, &value[0]); }
+    static void upload(int location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+    static void upload(int location, const glm::vec4& value) { glUniform4fv(location, 1, &value[0]); }
+    static void upload(int location, const glm::mat2& mat) { glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]); }
+    static void upload(int location, const glm::mat3& mat) { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+    static void upload(int location, const glm::mat4& mat) { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+
+    // 读取着色器源文件，构建目录中找不到时尝试项目根目录
+    static std::string readSource(const char* path) {
+        std::ifstream shaderFile;
+        shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        
+        try {
+            shaderFile.open(path);
+            std::stringstream shaderStream;
+            shaderStream << shaderFile.rdbuf();
+            shaderFile.close();
+            return expandIncludes(shaderStream.str(), path);
+        }
+        catch(std::ifstream::failure& e) {
+            std::cout << "错误::着色器::文件读取失败: " << e.what() << std::endl;
+        }
+        
+        // 如果构建目录失败，尝试在项目根目录查找文件
+        try {
+            shaderFile.open(std::string("../") + path);
+            std::stringstream shaderStream;
+            shaderStream << shaderFile.rdbuf();
+            shaderFile.close();
+            std::cout << "成功从项目根目录加载着色器" << std::endl;
+            return expandIncludes(shaderStream.str(), path);
+        }
+        catch(std::ifstream::failure& e) {
+            // 如果无法加载文件，使用硬编码着色器
+            // 这将在writeShaderFiles()函数中处理
+            std::cerr << "错误: 从构建目录和项目目录都无法读取着色器文件: " << path << std::endl;
+        }
+        return std::string();
+    }
+
+    // 把 #include "文件名" 行替换为与 path 同一目录下该文件的内容（多个着色器共用的函数只保存一份）
+    static std::string expandIncludes(const std::string& source, const std::string& path) {
+        const std::string directive = "#include \"";
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        std::istringstream lines(source);
+        std::string line, result;
+        while (std::getline(lines, line)) {
+            if (line.compare(0, directive.size(), directive) == 0) {
+                size_t end = line.find('"', directive.size());
+                result += readSource((directory + line.substr(directive.size(), end - directive.size())).c_str());
+            } else {
+                result += line;
+                result += '\n';
+            }
+        }
+        return result;
+    }
+
+    unsigned int compile(GLenum type, const std::string& code, const std::string& typeName) {
+        const char* source = code.c_str();
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        checkCompileErrors(shader, typeName);
+        return shader;
+    }
+
+    void checkCompileErrors(unsigned int shader, std::string type) {
+        int success;
+        char infoLog[1024];
+        if (type != "PROGRAM") {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if (!success) {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+    }
+};
+
+// 工作窃取任务系统
+// 每个线程持有一个任务双端队列：自己从队尾取，空闲时从其他线程队首窃取。
+// parallelFor 按固定块大小切分区间，调用线程也参与执行，返回时所有块均已完成。
+class JobSystem {
+public:
+    typedef std::function<void(int begin, int end, int chunk)> RangeFunction;
+
+    JobSystem() : running(false), queuedJobs(0) {
+    }
+
+    ~JobSystem() {
+        stop();
+    }
+
+    // 启动指定数量的工作线程（0 表示只在调用线程上执行）
+    void start(int workerCount) {
+        stop();
+        queues.clear();
+        for (int i = 0; i <= workerCount; i++) {
+            queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+        }
+        running = true;
+        for (int i = 0; i < workerCount; i++) {
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // 参与执行的线程总数（工作线程 + 调用线程）
+    int threadCount() const {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    // 块的划分只取决于 count 和 chunkSize，与线程数无关
+    void parallelFor(int count, int chunkSize, const RangeFunction& function) {
+        int chunkCount = (count + chunkSize - 1) / chunkSize;
+        if (chunkCount <= 1 || workers.empty()) {
+            for (int chunk = 0; chunk < chunkCount; chunk++) {
+                function(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize), chunk);
+            }
+            return;
+        }
+
+        std::atomic<int> remaining(chunkCount);
+        int queueCount = static_cast<int>(queues.size());
+        for (int chunk = 0; chunk < chunkCount; chunk++) {
+            Job job = { &function, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize), chunk, &remaining };
+            WorkerQueue& queue = *queues[chunk % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(job);
+        }
+        // 计数不需要锁；只为通知短暂持有 sleepMutex，避免与正在检查条件、尚未进入等待的线程错过唤醒
+        queuedJobs.fetch_add(chunkCount, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wakeCondition.notify_all();
+
+        // 调用线程使用最后一个队列
+        int self = queueCount - 1;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            Job job;
+            if (popJob(self, job) || stealJob(self, job)) {
+                runJob(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Job {
+        const RangeFunction* function;
+        int begin;
+        int end;
+        int chunk;
+        std::atomic<int>* remaining;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    bool running;
+    std::atomic<int> queuedJobs;  // 已入队未开始的块数，空闲线程据此决定是否睡眠
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+
+    bool popJob(int index, Job& job) {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) return false;
+        job = queue.jobs.back();
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    bool stealJob(int thief, Job& job) {
+        int queueCount = static_cast<int>(queues.size());
+        for (int offset = 1; offset < queueCount; offset++) {
+            WorkerQueue& queue = *queues[(thief + offset) % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runJob(const Job& job) {
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        (*job.function)(job.begin, job.end, job.chunk);
+        job.remaining->fetch_sub(1, std::memory_order_release);
+    }
+
+    void workerLoop(int index) {
+        while (true) {
+            Job job;
+            if (popJob(index, job) || stealJob(index, job)) {
+                runJob(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeCondition.wait(lock, [this] { return !running || queuedJobs.load(std::memory_order_acquire) > 0; });
+            if (!running) return;
+        }
+    }
+};
+
+// 拖尾池 - 每条拖尾占一个固定长度的环形槽位，槽位通过空闲链表分配和回收
+// 写入新记录只移动环形头指针；透明度按写入时刻的衰减计数在读取时计算，无需逐帧修改历史
+class TrailPool {
+public:
+    static const int SLOT_LENGTH = 12;  // 拖尾历史上限（近处雨滴 4 + 8）
+
+    std::vector<glm::vec3> positions;   // slotCount * SLOT_LENGTH
+    std::vector<float> alphas;          // 写入时的透明度
+    std::vector<uint32_t> stamps;       // 写入时所属雨滴的衰减计数
+
+    void init(int slotCount) {
+        positions.resize(static_cast<size_t>(slotCount) * SLOT_LENGTH);
+        alphas.resize(static_cast<size_t>(slotCount) * SLOT_LENGTH);
+        stamps.resize(static_cast<size_t>(slotCount) * SLOT_LENGTH);
+        freeSlots.resize(slotCount);
+        for (int s = 0; s < slotCount; s++) {
+            freeSlots[s] = slotCount - 1 - s; // 低编号槽位先分配
+        }
+    }
+
+    // 分配一个槽位，没有空闲槽位时返回 -1
+    int acquire() {
+        if (freeSlots.empty()) return -1;
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    void release(int slot) {
+        freeSlots.push_back(slot);
+    }
+
+    size_t base(int slot) const {
+        return static_cast<size_t>(slot) * SLOT_LENGTH;
+    }
+
+private:
+    std::vector<int> freeSlots;
+};
+
+// 雨滴池 - SoA布局的固定容量存储
+// 所有属性按字段连续存放，删除时与末尾元素交换（O(1)），稳定运行时不产生任何堆分配
+class RaindropPool {
+public:
+    static constexpr float TRAIL_DECAY = 0.98f; // 拖尾每次更新的透明度衰减
+
+    int capacity;
+    int count;
+    int farBegin;        // [0, farBegin) 为近/中层，[farBegin, count) 为远层
+    float lodFarDepth;   // layerDepth 达到该值的雨滴归入远层
+    double stepStart;    // 本步起点的模拟时间，新生成的雨滴从这里开始积分
+
+    // 运动状态
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> prevX, prevY, prevZ;   // 上一步的位置，渲染时与当前位置插值
+    // 竖直方向按解析解计算：y = startY + startVelY * t - gravity * t² / 2（t 为 lifetime），落水时刻在生成时即可确定
+    std::vector<float> startY, startVelY, gravity;
+
+    // 生命周期与外观
+    std::vector<float> lifetime;
+    std::vector<float> lifespan;
+    std::vector<float> size;
+    std::vector<float> brightness;
+    std::vector<float> twinkleSpeed;
+    std::vector<float> layerDepth;            // 层次深度 (0=近, 1=远)
+    std::vector<uint8_t> colorIndex;          // config.raindropColors 下标
+    std::vector<double> integratedTime;       // 已积分到的模拟时间（远层隔步积分、层间搬移后各不相同）
+
+    // 拖尾 - 历史记录存放在共享的拖尾池中，雨滴只保存槽位和环形头指针
+    TrailPool trails;
+    std::vector<int> trailSlot;
+    std::vector<uint8_t> trailHead;           // 最新记录在槽位内的位置
+    std::vector<uint8_t> trailLength;
+    std::vector<uint8_t> maxTrailLength;
+    std::vector<float> trailUpdateTime;
+    std::vector<float> trailUpdateInterval;
+    std::vector<uint32_t> trailTicks;         // 拖尾已衰减的次数
+    std::vector<int> indexOfSlot;             // 拖尾槽位 -> 雨滴当前下标（-1 表示空闲）
+
+    RaindropPool() : capacity(0), count(0), farBegin(0), lodFarDepth(0.7f), stepStart(0.0) {}
+
+    // 对每个按雨滴下标存放的数组执行 f（新增字段只需在这里登记）
+    template <typename F>
+    void forEachArray(F f) {
+        f(posX); f(posY); f(posZ);
+        f(velX); f(velY); f(velZ);
+        f(prevX); f(prevY); f(prevZ);
+        f(startY); f(startVelY); f(gravity);
+        f(lifetime);
+        f(lifespan);
+        f(size);
+        f(brightness);
+        f(twinkleSpeed);
+        f(layerDepth);
+        f(colorIndex);
+        f(integratedTime);
+        f(trailSlot);
+        f(trailHead);
+        f(trailLength);
+        f(maxTrailLength);
+        f(trailUpdateTime);
+        f(trailUpdateInterval);
+        f(trailTicks);
+    }
+
+    // 一次性分配全部存储
+    void init(int _capacity) {
+        capacity = _capacity;
+        count = 0;
+        farBegin = 0;
+
+        forEachArray([this](auto& array) { array.resize(capacity); });
+        trails.init(capacity);
+        indexOfSlot.assign(capacity, -1);
+    }
+
+    bool full() const {
+        return count >= capacity;
+    }
+
+    glm::vec3 position(int i) const {
+        return glm::vec3(posX[i], posY[i], posZ[i]);
+    }
+
+    // 上一步与当前位置之间的插值（alpha = 0 为上一步）
+    glm::vec3 interpolatedPosition(int i, float alpha) const {
+        return glm::vec3(prevX[i] + (posX[i] - prevX[i]) * alpha,
+                         prevY[i] + (posY[i] - prevY[i]) * alpha,
+                         prevZ[i] + (posZ[i] - prevZ[i]) * alpha);
+    }
+
+    // 积分前保存 [begin, end) 的位置
+    void savePositions(int begin, int end) {
+        std::copy(posX.begin() + begin, posX.begin() + end, prevX.begin() + begin);
+        std::copy(posY.begin() + begin, posY.begin() + end, prevY.begin() + begin);
+        std::copy(posZ.begin() + begin, posZ.begin() + end, prevZ.begin() + begin);
+    }
+
+    static const int SPAWN_RANDOMS = 7; // 每个新雨滴消耗的随机数个数
+
+    // 生成新雨滴，池满时返回 -1
+    int spawn(const glm::vec3& _position, int _colorIndex, CounterRng& rng) {
+        if (full()) return -1;
+
+        // 根据距离调整雨滴属性 - 实现层次感
+        float distanceFromCamera = glm::length(_position - glm::vec3(0.0f, 60.0f, 120.0f)); // 假设摄像机位置
+        float depth = std::min(distanceFromCamera / 200.0f, 1.0f); // 0-1范围
+
+        // 远层雨滴追加到末尾；近层雨滴放在 farBegin 处，原来的第一个远层雨滴搬到末尾
+        int i;
+        if (depth >= lodFarDepth) {
+            i = count++;
+        } else {
+            i = farBegin++;
+            if (i != count) moveDrop(count, i);
+            count++;
+        }
+
+        posX[i] = _position.x;
+        posY[i] = _position.y;
+        posZ[i] = _position.z;
+        prevX[i] = _position.x;
+        prevY[i] = _position.y;
+        prevZ[i] = _position.z;
+        colorIndex[i] = static_cast<uint8_t>(_colorIndex);
+        layerDepth[i] = depth;
+        integratedTime[i] = stepStart;
+
+        float random[SPAWN_RANDOMS];
+        rng.fillUniform(random, SPAWN_RANDOMS);
+
+        velX[i] = (random[0] - 0.5f) * 1.0f; // 增加水平运动
+        velY[i] = -3.0f - random[1] * 5.0f;  // 更大的垂直速度变化
+        velZ[i] = (random[2] - 0.5f) * 1.0f;
+
+        // 近处雨滴更大更慢，远处雨滴更小更快
+        size[i] = (2.0f - depth) * (1.0f + random[3] * 2.0f);
+        velY[i] *= 0.7f + depth * 0.6f; // 远处雨滴下落更快
+        startY[i] = _position.y;
+        startVelY[i] = velY[i];
+        gravity[i] = 2.0f * (0.8f + depth * 0.4f); // 远处雨滴受重力影响更大
+
+        lifespan[i] = 4.0f + random[4] * 4.0f;
+        lifetime[i] = 0.0f;
+        brightness[i] = 0.8f + random[5] * 0.4f;
+        twinkleSpeed[i] = 1.0f + random[6] * 5.0f;
+
+        // 初始化拖尾系统
+        maxTrailLength[i] = static_cast<uint8_t>(4 + static_cast<int>((1.0f - depth) * 8)); // 近处拖尾更长
+        trailUpdateInterval[i] = 0.03f + depth * 0.02f; // 远处更新更快
+        trailSlot[i] = trails.acquire(); // 拖尾池与雨滴池等容量，池未满时总能分配成功
+        indexOfSlot[trailSlot[i]] = i;
+        trailHead[i] = 0;
+        trailLength[i] = 0;
+        trailUpdateTime[i] = 0.0f;
+        trailTicks[i] = 0;
+
+        return i;
+    }
+
+    // 把 src 处的雨滴复制到 dst（不处理拖尾槽位的归属）
+    void moveDrop(int dst, int src) {
+        forEachArray([dst, src](auto& array) { array[dst] = array[src]; });
+        indexOfSlot[trailSlot[dst]] = dst;
+    }
+
+    void swapDrops(int a, int b) {
+        forEachArray([a, b](auto& array) { std::swap(array[a], array[b]); });
+        indexOfSlot[trailSlot[a]] = a;
+        indexOfSlot[trailSlot[b]] = b;
     }
-    void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+
+    // 拖尾槽位在雨滴存活期间不变，兼作雨滴的稳定句柄（下标会因交换删除和分层而变化）
+    int indexOf(int slot) const {
+        return indexOfSlot[slot];
     }
-    void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+
+    // 从生成到落水所需的时间：解 startY + v0 t - g t² / 2 = WATER_HEIGHT 的正根
+    float impactTime(int i) const {
+        float height = std::max(startY[i] - WATER_HEIGHT, 0.0f);
+        float v0 = startVelY[i];
+        return (v0 + std::sqrt(v0 * v0 + 2.0f * gravity[i] * height)) / gravity[i];
     }
-    void setVec2(const std::string &name, const glm::vec2 &value) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+
+    // 交换删除：近层用最后一个近层雨滴填补，再用末尾雨滴填补远层留下的空位，保持分区连续
+    void remove(int i) {
+        trails.release(trailSlot[i]);
+        indexOfSlot[trailSlot[i]] = -1;
+
+        if (i < farBegin) {
+            int lastNear = --farBegin;
+            if (i != lastNear) moveDrop(i, lastNear);
+            i = lastNear;
+        }
+        int last = --count;
+        if (i != last) moveDrop(i, last);
     }
-    void setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+
+    void clear() {
+        while (count > 0) {
+            remove(count - 1);
+        }
     }
-    void setVec4(const std::string &name, const glm::vec4 &value) const {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+
+    // 按积分后的 layerDepth 在近层和远层之间搬移雨滴，返回中层数量
+    int reclassify(float midDepth) {
+        int midCount = 0;
+        int i = 0;
+        while (i < farBegin) {
+            if (layerDepth[i] >= lodFarDepth) {
+                trailLength[i] = 0; // 远层不保留拖尾
+                swapDrops(i, --farBegin); // 换进来的雨滴还没检查，i 不前进
+            } else {
+                if (layerDepth[i] >= midDepth) midCount++;
+                i++;
+            }
+        }
+        for (i = farBegin; i < count; i++) {
+            if (layerDepth[i] < lodFarDepth - LOD_HYSTERESIS) {
+                if (layerDepth[i] >= midDepth) midCount++;
+                swapDrops(i, farBegin++);
+            }
+        }
+        return midCount;
     }
-    void setMat2(const std::string &name, const glm::mat2 &mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+
+    bool isDead(int i) const {
+        return lifetime[i] > lifespan[i];
     }
-    void setMat3(const std::string &name, const glm::mat3 &mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+
+    // 第 k 新的拖尾记录在拖尾池中的下标（k = 0 为最新）
+    size_t trailSample(int i, int k) const {
+        int offset = (trailHead[i] - k + TrailPool::SLOT_LENGTH) % TrailPool::SLOT_LENGTH;
+        return trails.base(trailSlot[i]) + offset;
     }
-    void setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+
+    // 按写入后经过的更新次数计算衰减后的透明度
+    float trailAlpha(int i, int k) const {
+        size_t sample = trailSample(i, k);
+        return trails.alphas[sample] * std::pow(TRAIL_DECAY, static_cast<float>(trailTicks[i] - trails.stamps[sample]));
     }
 
-private:
-    void checkCompileErrors(unsigned int shader, std::string type) {
-        int success;
-        char infoLog[1024];
-        if (type != "PROGRAM") {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if (!success) {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    // 按降序回收两个升序下标列表中的雨滴，保证交换删除不会搬动尚未处理的下标
+    void removeSorted(const int* a, int countA, const int* b, int countB) {
+        while (countA > 0 || countB > 0) {
+            if (countB == 0 || (countA > 0 && a[countA - 1] > b[countB - 1])) {
+                remove(a[--countA]);
+            } else {
+                remove(b[--countB]);
+            }
+        }
+    }
+
+    // 更新拖尾效果
+    void updateTrail(int i, float deltaTime) {
+        trailUpdateTime[i] += deltaTime;
+
+        if (trailUpdateTime[i] >= trailUpdateInterval[i]) {
+            // 添加当前位置到拖尾（头指针前移一格，超出上限的最旧记录被覆盖）
+            int head = (trailHead[i] + 1) % TrailPool::SLOT_LENGTH;
+            size_t sample = trails.base(trailSlot[i]) + head;
+            trails.positions[sample] = position(i);
+            trails.alphas[sample] = brightness[i];
+            trails.stamps[sample] = trailTicks[i];
+            trailHead[i] = static_cast<uint8_t>(head);
+            trailLength[i] = static_cast<uint8_t>(std::min(trailLength[i] + 1, static_cast<int>(maxTrailLength[i])));
+
+            trailUpdateTime[i] = 0.0f;
+        }
+
+        // 拖尾透明度逐渐衰减（读取时按次数计算）
+        trailTicks[i]++;
+    }
+};
+
+// 分层时间轮 - 雨滴、涟漪和闪电生成时登记到期时刻，到期时成批取出，不需要逐个扫描
+// 每层 64 格，第 L 层一格跨 64^L 个刻度。条目放在与当前时刻第一个不同的 6 位分组所在的层，
+// 低层转完一圈时把上层对应格子的条目重新分配到低层；只有第 0 层的格子会真正触发。
+enum TimerKind {
+    TIMER_RAINDROP_IMPACT,  // 雨滴落水（id 为拖尾槽位）
+    TIMER_RAINDROP_EXPIRE,  // 雨滴寿命结束
+    TIMER_RIPPLE,           // 涟漪消失（id 和 generation 为涟漪句柄）
+    TIMER_LIGHTNING         // 闪电结束（id 为闪电编号）
+};
+
+class TimingWheel {
+public:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;            // 共 2^24 个刻度
+
+    struct Entry {
+        uint64_t deadline;
+        int id;
+        uint32_t generation;  // 带代数的编号（涟漪句柄）使用，其余为 0
+        TimerKind kind;
+    };
+
+    TimingWheel() : now(0), pending(0) {}
+
+    uint64_t currentTick() const {
+        return now;
+    }
+
+    int size() const {
+        return pending;
+    }
+
+    // 登记在 deadline 刻度到期的条目；已经过去的时刻在下一个刻度触发
+    void schedule(uint64_t deadline, TimerKind kind, int id, uint32_t generation = 0) {
+        insert({ std::max(deadline, now + 1), id, generation, kind });
+        pending++;
+    }
+
+    // 前进到 tick，途经各刻度到期的条目按刻度顺序追加到 fired
+    void advance(uint64_t tick, std::vector<Entry>& fired) {
+        while (now < tick) {
+            now++;
+            // 先从最高的转圈层开始往下分配，保证上层条目能落入随后分配的低层格子
+            int topLevel = 0;
+            while (topLevel + 1 < LEVELS && (now & levelMask(topLevel + 1)) == 0) topLevel++;
+            for (int level = topLevel; level >= 1; level--) {
+                std::vector<Entry>& slot = slots[level][slotIndex(now, level)];
+                cascade.swap(slot);
+                for (const Entry& entry : cascade) insert(entry);
+                cascade.clear();
+            }
+            std::vector<Entry>& due = slots[0][slotIndex(now, 0)];
+            fired.insert(fired.end(), due.begin(), due.end());
+            pending -= static_cast<int>(due.size());
+            due.clear();
+        }
+    }
+
+private:
+    uint64_t now;
+    int pending;
+    std::vector<Entry> slots[LEVELS][SLOTS];  // 格子清空后保留容量，稳定运行时不再分配
+    std::vector<Entry> cascade;
+
+    static uint64_t levelMask(int level) {
+        return (uint64_t(1) << (SLOT_BITS * level)) - 1;
+    }
+
+    static int slotIndex(uint64_t tick, int level) {
+        return static_cast<int>((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+
+    void insert(const Entry& entry) {
+        int level = 0;
+        while (level + 1 < LEVELS && (entry.deadline >> (SLOT_BITS * (level + 1))) != (now >> (SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+        slots[level][slotIndex(entry.deadline, level)].push_back(entry);
+    }
+};
+
+// 编号表 - 为存放在密集数组中的对象分配稳定编号；交换删除改变下标后用 move 更新，编号经空闲链表回收
+class IdTable {
+public:
+    int acquire(int index) {
+        int id;
+        if (freeIds.empty()) {
+            id = static_cast<int>(indexOfId.size());
+            indexOfId.push_back(index);
+        } else {
+            id = freeIds.back();
+            freeIds.pop_back();
+            indexOfId[id] = index;
+        }
+        return id;
+    }
+
+    void release(int id) {
+        indexOfId[id] = -1;
+        freeIds.push_back(id);
+    }
+
+    void move(int id, int index) {
+        indexOfId[id] = index;
+    }
+
+    int indexOf(int id) const {
+        return indexOfId[id];
+    }
+
+private:
+    std::vector<int> indexOfId;
+    std::vector<int> freeIds;
+};
+
+// ---------------------------------------------------------------------------
+// 雨滴批量积分核心
+// 同一套运动方程提供标量 / SSE2 / AVX2 三种实现，启动时按CPU能力选择。
+// 每次调用积分 [begin, end) 区间内的雨滴。落水和寿命结束由生成时排入的事件队列处理，积分中不做水面检测。
+// ---------------------------------------------------------------------------
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RAIN_TARGET_SSE2 __attribute__((target("sse2")))
+#define RAIN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define RAIN_TARGET_SSE2
+#define RAIN_TARGET_AVX2
+#endif
+
+enum SimdLevel {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SIMD_SSE2: return "SSE2";
+        case SIMD_AVX2: return "AVX2";
+        default: return "Scalar";
+    }
+}
+
+// 运行时检测可用指令集
+SimdLevel detectSimdLevel() {
+#if RAIN_SIMD_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx2 = false;
+    if (osxsave && (_xgetbv(0) & 6) == 6) { // 操作系统保存YMM寄存器
+        __cpuidex(info, 7, 0);
+        avx2 = fma && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    if (avx2) return SIMD_AVX2;
+    if (sse2) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+// detailed 为 false 时（远层雨滴）跳过闪烁亮度和摆动的三角函数，只保留阻尼和重力
+typedef void (*RaindropKernel)(RaindropPool& pool, int begin, int end, float deltaTime,
+                               const glm::vec3& cameraPos, bool detailed);
+
+// 单个雨滴的标量积分，也是各SIMD实现处理尾部元素的路径
+inline void integrateRaindrop(RaindropPool& pool, int i, float deltaTime,
+                              const glm::vec3& cameraPos, bool detailed) {
+    float lifetime = pool.lifetime[i] + deltaTime;
+    pool.lifetime[i] = lifetime;
+
+    // Update distance from camera for layer depth calculation
+    float dx = pool.posX[i] - cameraPos.x;
+    float dy = pool.posY[i] - cameraPos.y;
+    float dz = pool.posZ[i] - cameraPos.z;
+    float depth = std::min(std::sqrt(dx * dx + dy * dy + dz * dz) / 200.0f, 1.0f);
+    pool.layerDepth[i] = depth;
+
+    // Enhanced twinkling with layer-based variations
+    if (detailed) {
+        float brightness = 0.7f + 0.3f * std::sin(lifetime * pool.twinkleSpeed[i] + pool.posX[i] * 0.1f);
+        pool.brightness[i] = brightness * (1.2f - depth * 0.4f); // 近处雨滴更亮
+    }
+
+    // 竖直方向取解析解；落水后到事件触发前停在水面
+    float x = pool.posX[i] + pool.velX[i] * deltaTime;
+    float y = std::max(pool.startY[i] + (pool.startVelY[i] - 0.5f * pool.gravity[i] * lifetime) * lifetime, WATER_HEIGHT);
+    float z = pool.posZ[i] + pool.velZ[i] * deltaTime;
+    pool.posX[i] = x;
+    pool.posY[i] = y;
+    pool.posZ[i] = z;
+
+    // Enhanced motion with layer-dependent swaying
+    float swayAmount = 0.1f * (1.0f - depth); // 近处雨滴摆动更明显
+    float swayX = detailed ? std::cos(lifetime * 3.0f + z) * swayAmount : 0.0f;
+    float swayZ = detailed ? std::sin(lifetime * 2.5f + x) * swayAmount : 0.0f;
+    pool.velX[i] += (swayX - pool.velX[i] * 0.1f) * deltaTime;
+    pool.velZ[i] += (swayZ - pool.velZ[i] * 0.1f) * deltaTime;
+
+    pool.velY[i] = pool.startVelY[i] - pool.gravity[i] * lifetime;
+}
+
+void integrateRaindropsScalar(RaindropPool& pool, int begin, int end, float deltaTime,
+                              const glm::vec3& cameraPos, bool detailed) {
+    for (int i = begin; i < end; i++) {
+        integrateRaindrop(pool, i, deltaTime, cameraPos, detailed);
+    }
+}
+
+#if RAIN_SIMD_X86
+
+// 多项式 sin 近似：按 π 归约到 [-π/2, π/2]，奇数象限翻转符号，最大误差约 2e-6
+RAIN_TARGET_SSE2 static inline __m128 fastSin4(__m128 x) {
+    const __m128 invPi = _mm_set1_ps(0.31830988618f);
+    const __m128 piHi = _mm_set1_ps(3.140625f);
+    const __m128 piLo = _mm_set1_ps(9.67653589793e-4f);
+    __m128i k = _mm_cvtps_epi32(_mm_mul_ps(x, invPi));
+    __m128 kf = _mm_cvtepi32_ps(k);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(kf, piHi)), _mm_mul_ps(kf, piLo));
+    __m128 r2 = _mm_mul_ps(r, r);
+    __m128 p = _mm_set1_ps(2.7525562e-6f);
+    p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(-1.9840874e-4f));
+    p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(8.3333310e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(-1.6666667e-1f));
+    p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r2), r), r);
+    __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(k, 31));
+    return _mm_xor_ps(p, sign);
+}
+
+RAIN_TARGET_SSE2 static inline __m128 fastCos4(__m128 x) {
+    return fastSin4(_mm_add_ps(x, _mm_set1_ps(1.57079632679f)));
+}
+
+// 积分4个相邻雨滴
+RAIN_TARGET_SSE2 static inline void integrateRaindrops4(RaindropPool& pool, int i, __m128 dt,
+                                                       __m128 camX, __m128 camY, __m128 camZ, bool detailed) {
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 lifetime = _mm_add_ps(_mm_loadu_ps(&pool.lifetime[i]), dt);
+    _mm_storeu_ps(&pool.lifetime[i], lifetime);
+
+    __m128 px = _mm_loadu_ps(&pool.posX[i]);
+    __m128 py = _mm_loadu_ps(&pool.posY[i]);
+    __m128 pz = _mm_loadu_ps(&pool.posZ[i]);
+    __m128 vx = _mm_loadu_ps(&pool.velX[i]);
+    __m128 vz = _mm_loadu_ps(&pool.velZ[i]);
+
+    __m128 dx = _mm_sub_ps(px, camX);
+    __m128 dy = _mm_sub_ps(py, camY);
+    __m128 dz = _mm_sub_ps(pz, camZ);
+    __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+    __m128 depth = _mm_min_ps(_mm_mul_ps(dist, _mm_set1_ps(1.0f / 200.0f)), one);
+    _mm_storeu_ps(&pool.layerDepth[i], depth);
+
+    if (detailed) {
+        __m128 phase = _mm_add_ps(_mm_mul_ps(lifetime, _mm_loadu_ps(&pool.twinkleSpeed[i])), _mm_mul_ps(px, _mm_set1_ps(0.1f)));
+        __m128 brightness = _mm_add_ps(_mm_set1_ps(0.7f), _mm_mul_ps(_mm_set1_ps(0.3f), fastSin4(phase)));
+        brightness = _mm_mul_ps(brightness, _mm_sub_ps(_mm_set1_ps(1.2f), _mm_mul_ps(depth, _mm_set1_ps(0.4f))));
+        _mm_storeu_ps(&pool.brightness[i], brightness);
+    }
+
+    __m128 startVelY = _mm_loadu_ps(&pool.startVelY[i]);
+    __m128 gravity = _mm_loadu_ps(&pool.gravity[i]);
+    px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+    py = _mm_sub_ps(startVelY, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), gravity), lifetime));
+    py = _mm_max_ps(_mm_add_ps(_mm_loadu_ps(&pool.startY[i]), _mm_mul_ps(py, lifetime)), _mm_set1_ps(WATER_HEIGHT));
+    pz = _mm_add_ps(pz, _mm_mul_ps(vz, dt));
+    _mm_storeu_ps(&pool.posX[i], px);
+    _mm_storeu_ps(&pool.posY[i], py);
+    _mm_storeu_ps(&pool.posZ[i], pz);
+
+    __m128 damping = _mm_set1_ps(0.1f);
+    __m128 swayX = _mm_setzero_ps();
+    __m128 swayZ = _mm_setzero_ps();
+    if (detailed) {
+        __m128 sway = _mm_mul_ps(_mm_set1_ps(0.1f), _mm_sub_ps(one, depth));
+        swayX = _mm_mul_ps(fastCos4(_mm_add_ps(_mm_mul_ps(lifetime, _mm_set1_ps(3.0f)), pz)), sway);
+        swayZ = _mm_mul_ps(fastSin4(_mm_add_ps(_mm_mul_ps(lifetime, _mm_set1_ps(2.5f)), px)), sway);
+    }
+    vx = _mm_add_ps(vx, _mm_mul_ps(_mm_sub_ps(swayX, _mm_mul_ps(vx, damping)), dt));
+    vz = _mm_add_ps(vz, _mm_mul_ps(_mm_sub_ps(swayZ, _mm_mul_ps(vz, damping)), dt));
+    _mm_storeu_ps(&pool.velX[i], vx);
+    _mm_storeu_ps(&pool.velY[i], _mm_sub_ps(startVelY, _mm_mul_ps(gravity, lifetime)));
+    _mm_storeu_ps(&pool.velZ[i], vz);
+}
+
+RAIN_TARGET_SSE2 void integrateRaindropsSSE2(RaindropPool& pool, int begin, int end, float deltaTime,
+                                             const glm::vec3& cameraPos, bool detailed) {
+    __m128 dt = _mm_set1_ps(deltaTime);
+    __m128 camX = _mm_set1_ps(cameraPos.x);
+    __m128 camY = _mm_set1_ps(cameraPos.y);
+    __m128 camZ = _mm_set1_ps(cameraPos.z);
+
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        integrateRaindrops4(pool, i, dt, camX, camY, camZ, detailed);
+    }
+    for (; i < end; i++) {
+        integrateRaindrop(pool, i, deltaTime, cameraPos, detailed);
+    }
+}
+
+RAIN_TARGET_AVX2 static inline __m256 fastSin8(__m256 x) {
+    const __m256 invPi = _mm256_set1_ps(0.31830988618f);
+    const __m256 piHi = _mm256_set1_ps(3.140625f);
+    const __m256 piLo = _mm256_set1_ps(9.67653589793e-4f);
+    __m256i k = _mm256_cvtps_epi32(_mm256_mul_ps(x, invPi));
+    __m256 kf = _mm256_cvtepi32_ps(k);
+    __m256 r = _mm256_fnmadd_ps(kf, piLo, _mm256_fnmadd_ps(kf, piHi, x));
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 p = _mm256_set1_ps(2.7525562e-6f);
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(-1.9840874e-4f));
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(8.3333310e-3f));
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(-1.6666667e-1f));
+    p = _mm256_fmadd_ps(_mm256_mul_ps(p, r2), r, r);
+    __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(k, 31));
+    return _mm256_xor_ps(p, sign);
+}
+
+RAIN_TARGET_AVX2 static inline __m256 fastCos8(__m256 x) {
+    return fastSin8(_mm256_add_ps(x, _mm256_set1_ps(1.57079632679f)));
+}
+
+// 积分8个相邻雨滴
+RAIN_TARGET_AVX2 static inline void integrateRaindrops8(RaindropPool& pool, int i, __m256 dt,
+                                                       __m256 camX, __m256 camY, __m256 camZ, bool detailed) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 lifetime = _mm256_add_ps(_mm256_loadu_ps(&pool.lifetime[i]), dt);
+    _mm256_storeu_ps(&pool.lifetime[i], lifetime);
+
+    __m256 px = _mm256_loadu_ps(&pool.posX[i]);
+    __m256 py = _mm256_loadu_ps(&pool.posY[i]);
+    __m256 pz = _mm256_loadu_ps(&pool.posZ[i]);
+    __m256 vx = _mm256_loadu_ps(&pool.velX[i]);
+    __m256 vz = _mm256_loadu_ps(&pool.velZ[i]);
+
+    __m256 dx = _mm256_sub_ps(px, camX);
+    __m256 dy = _mm256_sub_ps(py, camY);
+    __m256 dz = _mm256_sub_ps(pz, camZ);
+    __m256 dist = _mm256_sqrt_ps(_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx))));
+    __m256 depth = _mm256_min_ps(_mm256_mul_ps(dist, _mm256_set1_ps(1.0f / 200.0f)), one);
+    _mm256_storeu_ps(&pool.layerDepth[i], depth);
+
+    if (detailed) {
+        __m256 phase = _mm256_fmadd_ps(lifetime, _mm256_loadu_ps(&pool.twinkleSpeed[i]), _mm256_mul_ps(px, _mm256_set1_ps(0.1f)));
+        __m256 brightness = _mm256_fmadd_ps(_mm256_set1_ps(0.3f), fastSin8(phase), _mm256_set1_ps(0.7f));
+        brightness = _mm256_mul_ps(brightness, _mm256_fnmadd_ps(depth, _mm256_set1_ps(0.4f), _mm256_set1_ps(1.2f)));
+        _mm256_storeu_ps(&pool.brightness[i], brightness);
+    }
+
+    __m256 startVelY = _mm256_loadu_ps(&pool.startVelY[i]);
+    __m256 gravity = _mm256_loadu_ps(&pool.gravity[i]);
+    px = _mm256_fmadd_ps(vx, dt, px);
+    py = _mm256_fnmadd_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), gravity), lifetime, startVelY);
+    py = _mm256_max_ps(_mm256_fmadd_ps(py, lifetime, _mm256_loadu_ps(&pool.startY[i])), _mm256_set1_ps(WATER_HEIGHT));
+    pz = _mm256_fmadd_ps(vz, dt, pz);
+    _mm256_storeu_ps(&pool.posX[i], px);
+    _mm256_storeu_ps(&pool.posY[i], py);
+    _mm256_storeu_ps(&pool.posZ[i], pz);
+
+    __m256 damping = _mm256_set1_ps(0.1f);
+    if (detailed) {
+        __m256 sway = _mm256_mul_ps(_mm256_set1_ps(0.1f), _mm256_sub_ps(one, depth));
+        __m256 swayX = fastCos8(_mm256_fmadd_ps(lifetime, _mm256_set1_ps(3.0f), pz));
+        __m256 swayZ = fastSin8(_mm256_fmadd_ps(lifetime, _mm256_set1_ps(2.5f), px));
+        vx = _mm256_fmadd_ps(_mm256_fmsub_ps(swayX, sway, _mm256_mul_ps(vx, damping)), dt, vx);
+        vz = _mm256_fmadd_ps(_mm256_fmsub_ps(swayZ, sway, _mm256_mul_ps(vz, damping)), dt, vz);
+    } else {
+        vx = _mm256_fnmadd_ps(_mm256_mul_ps(vx, damping), dt, vx);
+        vz = _mm256_fnmadd_ps(_mm256_mul_ps(vz, damping), dt, vz);
+    }
+    _mm256_storeu_ps(&pool.velX[i], vx);
+    _mm256_storeu_ps(&pool.velY[i], _mm256_fnmadd_ps(gravity, lifetime, startVelY));
+    _mm256_storeu_ps(&pool.velZ[i], vz);
+}
+
+RAIN_TARGET_AVX2 void integrateRaindropsAVX2(RaindropPool& pool, int begin, int end, float deltaTime,
+                                             const glm::vec3& cameraPos, bool detailed) {
+    __m256 dt = _mm256_set1_ps(deltaTime);
+    __m256 camX = _mm256_set1_ps(cameraPos.x);
+    __m256 camY = _mm256_set1_ps(cameraPos.y);
+    __m256 camZ = _mm256_set1_ps(cameraPos.z);
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        integrateRaindrops8(pool, i, dt, camX, camY, camZ, detailed);
+    }
+    for (; i < end; i++) {
+        integrateRaindrop(pool, i, deltaTime, cameraPos, detailed);
+    }
+}
+
+#endif // RAIN_SIMD_X86
+
+// 选取不超过CPU支持级别的积分实现
+RaindropKernel selectRaindropKernel(SimdLevel level) {
+#if RAIN_SIMD_X86
+    if (level == SIMD_AVX2) return integrateRaindropsAVX2;
+    if (level == SIMD_SSE2) return integrateRaindropsSSE2;
+#endif
+    return integrateRaindropsScalar;
+}
+
+// ---------------------------------------------------------------------------
+// 视锥剔除
+// 从 projection * view 提取6个平面（法线指向视锥内部），批量做球体与平面测试，
+// 输出可见对象的紧凑下标列表。与积分核心一样提供标量 / SSE2 / AVX2 三种实现。
+// ---------------------------------------------------------------------------
+
+struct Frustum {
+    // 平面按分量分开存放，便于SIMD广播：nx * x + ny * y + nz * z + d >= 0 表示在内侧
+    float nx[6], ny[6], nz[6], d[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection) {
+        Frustum frustum;
+        for (int p = 0; p < 6; p++) {
+            int axis = p / 2;
+            float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+            // 第4行 ± 第 axis 行（glm 按列存储）
+            glm::vec4 plane(viewProjection[0][3] + sign * viewProjection[0][axis],
+                            viewProjection[1][3] + sign * viewProjection[1][axis],
+                            viewProjection[2][3] + sign * viewProjection[2][axis],
+                            viewProjection[3][3] + sign * viewProjection[3][axis]);
+            plane /= glm::length(glm::vec3(plane));
+            frustum.nx[p] = plane.x;
+            frustum.ny[p] = plane.y;
+            frustum.nz[p] = plane.z;
+            frustum.d[p] = plane.w;
+        }
+        return frustum;
+    }
+
+    bool containsSphere(float x, float y, float z, float radius) const {
+        for (int p = 0; p < 6; p++) {
+            if (nx[p] * x + ny[p] * y + nz[p] * z + d[p] < -radius) return false;
+        }
+        return true;
+    }
+};
+
+// 测试 [begin, end) 内的球体，可见下标按升序写入 visible，返回数量
+// radii 为空时所有球体使用同一半径 radius
+typedef int (*CullKernel)(const Frustum& frustum, const float* x, const float* y, const float* z,
+                          const float* radii, float radius, int begin, int end, int* visible);
+
+int cullSpheresScalar(const Frustum& frustum, const float* x, const float* y, const float* z,
+                      const float* radii, float radius, int begin, int end, int* visible) {
+    int visibleCount = 0;
+    for (int i = begin; i < end; i++) {
+        if (frustum.containsSphere(x[i], y[i], z[i], radii ? radii[i] : radius)) {
+            visible[visibleCount++] = i;
+        }
+    }
+    return visibleCount;
+}
+
+#if RAIN_SIMD_X86
+
+RAIN_TARGET_SSE2 int cullSpheresSSE2(const Frustum& frustum, const float* x, const float* y, const float* z,
+                                     const float* radii, float radius, int begin, int end, int* visible) {
+    int visibleCount = 0;
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radii ? _mm_loadu_ps(radii + i) : _mm_set1_ps(radius));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(frustum.nx[p])),
+                                                    _mm_mul_ps(cy, _mm_set1_ps(frustum.ny[p]))),
+                                         _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(frustum.nz[p])), _mm_set1_ps(frustum.d[p])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++) {
+            if (mask & (1 << lane)) visible[visibleCount++] = i + lane;
+        }
+    }
+    return visibleCount + cullSpheresScalar(frustum, x, y, z, radii, radius, i, end, visible + visibleCount);
+}
+
+RAIN_TARGET_AVX2 int cullSpheresAVX2(const Frustum& frustum, const float* x, const float* y, const float* z,
+                                     const float* radii, float radius, int begin, int end, int* visible) {
+    int visibleCount = 0;
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(x + i);
+        __m256 cy = _mm256_loadu_ps(y + i);
+        __m256 cz = _mm256_loadu_ps(z + i);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), radii ? _mm256_loadu_ps(radii + i) : _mm256_set1_ps(radius));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_fmadd_ps(cx, _mm256_set1_ps(frustum.nx[p]),
+                              _mm256_fmadd_ps(cy, _mm256_set1_ps(frustum.ny[p]),
+                              _mm256_fmadd_ps(cz, _mm256_set1_ps(frustum.nz[p]), _mm256_set1_ps(frustum.d[p]))));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+        int mask = _mm256_movemask_ps(inside);
+        if (mask == 0) continue;
+        for (int lane = 0; lane < 8; lane++) {
+            if (mask & (1 << lane)) visible[visibleCount++] = i + lane;
+        }
+    }
+    return visibleCount + cullSpheresScalar(frustum, x, y, z, radii, radius, i, end, visible + visibleCount);
+}
+
+#endif // RAIN_SIMD_X86
+
+CullKernel selectCullKernel(SimdLevel level) {
+#if RAIN_SIMD_X86
+    if (level == SIMD_AVX2) return cullSpheresAVX2;
+    if (level == SIMD_SSE2) return cullSpheresSSE2;
+#endif
+    return cullSpheresScalar;
+}
+
+// ---------------------------------------------------------------------------
+// 基2 FFT 蝶形运算
+// a = [0, half)，b = [half, 2 * half)：t = b * w，b = a - t，a = a + t（实部虚部分开存放，循环按 j 连续）
+// ---------------------------------------------------------------------------
+typedef void (*FftButterflyKernel)(float* re, float* im, const float* twiddleRe, const float* twiddleIm, int half);
+
+void fftButterfliesScalar(float* re, float* im, const float* twiddleRe, const float* twiddleIm, int half) {
+    for (int j = 0; j < half; j++) {
+        float br = re[j + half], bi = im[j + half];
+        float tr = br * twiddleRe[j] - bi * twiddleIm[j];
+        float ti = br * twiddleIm[j] + bi * twiddleRe[j];
+        re[j + half] = re[j] - tr;
+        im[j + half] = im[j] - ti;
+        re[j] += tr;
+        im[j] += ti;
+    }
+}
+
+#if RAIN_SIMD_X86
+
+RAIN_TARGET_SSE2 void fftButterfliesSSE2(float* re, float* im, const float* twiddleRe, const float* twiddleIm, int half) {
+    if (half < 4) {
+        fftButterfliesScalar(re, im, twiddleRe, twiddleIm, half);
+        return;
+    }
+    for (int j = 0; j < half; j += 4) {
+        __m128 ar = _mm_loadu_ps(re + j), ai = _mm_loadu_ps(im + j);
+        __m128 br = _mm_loadu_ps(re + j + half), bi = _mm_loadu_ps(im + j + half);
+        __m128 wr = _mm_loadu_ps(twiddleRe + j), wi = _mm_loadu_ps(twiddleIm + j);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+        _mm_storeu_ps(re + j + half, _mm_sub_ps(ar, tr));
+        _mm_storeu_ps(im + j + half, _mm_sub_ps(ai, ti));
+        _mm_storeu_ps(re + j, _mm_add_ps(ar, tr));
+        _mm_storeu_ps(im + j, _mm_add_ps(ai, ti));
+    }
+}
+
+RAIN_TARGET_AVX2 void fftButterfliesAVX2(float* re, float* im, const float* twiddleRe, const float* twiddleIm, int half) {
+    if (half < 8) {
+        fftButterfliesSSE2(re, im, twiddleRe, twiddleIm, half);
+        return;
+    }
+    for (int j = 0; j < half; j += 8) {
+        __m256 ar = _mm256_loadu_ps(re + j), ai = _mm256_loadu_ps(im + j);
+        __m256 br = _mm256_loadu_ps(re + j + half), bi = _mm256_loadu_ps(im + j + half);
+        __m256 wr = _mm256_loadu_ps(twiddleRe + j), wi = _mm256_loadu_ps(twiddleIm + j);
+        __m256 tr = _mm256_fmsub_ps(br, wr, _mm256_mul_ps(bi, wi));
+        __m256 ti = _mm256_fmadd_ps(br, wi, _mm256_mul_ps(bi, wr));
+        _mm256_storeu_ps(re + j + half, _mm256_sub_ps(ar, tr));
+        _mm256_storeu_ps(im + j + half, _mm256_sub_ps(ai, ti));
+        _mm256_storeu_ps(re + j, _mm256_add_ps(ar, tr));
+        _mm256_storeu_ps(im + j, _mm256_add_ps(ai, ti));
+    }
+}
+
+#endif // RAIN_SIMD_X86
+
+FftButterflyKernel selectFftButterflyKernel(SimdLevel level) {
+#if RAIN_SIMD_X86
+    if (level == SIMD_AVX2) return fftButterfliesAVX2;
+    if (level == SIMD_SSE2) return fftButterfliesSSE2;
+#endif
+    return fftButterfliesScalar;
+}
+
+// 积分微基准：各指令集实现与标量循环的吞吐对比（命令行 --bench）
+void runIntegrationBenchmark() {
+    const int dropCount = 1 << 20;
+    const int steps = 60;
+    const float deltaTime = 1.0f / 120.0f;
+    const glm::vec3 cameraPos(0.0f, 60.0f, 120.0f);
+
+    // 生成固定场景
+    CounterRng sceneRng(12345);
+    RaindropPool reference;
+    reference.init(dropCount);
+    while (!reference.full()) {
+        glm::vec3 position(
+            cameraPos.x + (sceneRng.uniform() - 0.5f) * 300.0f,
+            cameraPos.y + 15.0f + sceneRng.uniform() * 70.0f,
+            cameraPos.z + (sceneRng.uniform() - 0.5f) * 300.0f);
+        reference.spawn(position, sceneRng.nextInt(5), sceneRng);
+    }
+
+    SimdLevel maxLevel = detectSimdLevel();
+    std::cout << "Raindrop integration benchmark: " << dropCount << " drops x " << steps
+              << " steps (CPU supports " << simdLevelName(maxLevel) << ")" << std::endl;
+
+    RaindropPool scalarResult, bestResult;
+    double scalarRate = 0.0;
+    for (int level = SIMD_SCALAR; level <= maxLevel; level++) {
+        RaindropPool pool = reference;
+        RaindropKernel kernel = selectRaindropKernel(static_cast<SimdLevel>(level));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int s = 0; s < steps; s++) {
+            kernel(pool, 0, pool.count, deltaTime, cameraPos, true);
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        double rate = double(dropCount) * steps / ms;
+
+        // 与标量结果的最大位置偏差，用于确认近似三角函数的精度
+        float maxError = 0.0f;
+        if (level == SIMD_SCALAR) {
+            scalarResult = pool;
+            scalarRate = rate;
+        } else {
+            for (int i = 0; i < pool.count; i++) {
+                maxError = std::max(maxError, glm::length(pool.position(i) - scalarResult.position(i)));
+            }
+        }
+
+        std::cout << "  " << simdLevelName(static_cast<SimdLevel>(level)) << ": "
+                  << rate << " drops/ms (" << rate / scalarRate << "x, max position error "
+                  << maxError << ")" << std::endl;
+        bestResult = pool;
+    }
+
+    // 多线程：最优实现分块并行，结果应与单线程逐位一致
+    JobSystem jobs;
+    jobs.start(std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    RaindropPool pool = reference;
+    RaindropKernel kernel = selectRaindropKernel(maxLevel);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int s = 0; s < steps; s++) {
+        jobs.parallelFor(pool.count, RAINDROP_JOB_CHUNK, [&](int begin, int end, int) {
+            kernel(pool, begin, end, deltaTime, cameraPos, true);
+        });
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    double rate = double(dropCount) * steps / std::chrono::duration<double, std::milli>(stop - start).count();
+    bool identical = std::equal(pool.posY.begin(), pool.posY.end(), bestResult.posY.begin())
+                  && std::equal(pool.velX.begin(), pool.velX.end(), bestResult.velX.begin());
+    std::cout << "  " << simdLevelName(maxLevel) << " x " << jobs.threadCount() << " threads: "
+              << rate << " drops/ms (" << rate / scalarRate << "x, "
+              << (identical ? "identical to" : "DIFFERS from") << " single-threaded)" << std::endl;
+}
+
+// GPU计时器 - GL_TIME_ELAPSED 查询环形缓冲，结果延迟几帧读取，不会让CPU等待GPU
+// 同一时刻只能有一个 GL_TIME_ELAPSED 查询处于活动状态，多个计时区间不能嵌套
+class GpuTimer {
+public:
+    static const int QUERY_COUNT = 4;
+
+    float smoothedMs;  // 平滑后的GPU耗时
+
+    GpuTimer() : smoothedMs(0.0f), initialized(false), active(false), next(0) {
+        for (int q = 0; q < QUERY_COUNT; q++) {
+            queries[q] = 0;
+            pending[q] = false;
+        }
+    }
+
+    void begin() {
+        if (!initialized) {
+            glGenQueries(QUERY_COUNT, queries);
+            initialized = true;
+        }
+        collect();
+
+        // 查询对象仍未返回结果时跳过本帧计时
+        active = !pending[next];
+        if (active) {
+            glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+        }
+    }
+
+    void end() {
+        if (!active) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % QUERY_COUNT;
+        active = false;
+    }
+
+    void release() {
+        if (initialized) {
+            glDeleteQueries(QUERY_COUNT, queries);
+            initialized = false;
+        }
+    }
+
+private:
+    unsigned int queries[QUERY_COUNT];
+    bool pending[QUERY_COUNT];
+    bool initialized;
+    bool active;
+    int next;
+
+    // 按提交顺序读取已完成的查询
+    void collect() {
+        for (int k = 0; k < QUERY_COUNT; k++) {
+            int q = (next + k) % QUERY_COUNT;
+            if (!pending[q]) continue;
+
+            GLint available = 0;
+            glGetQueryObjectiv(queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[q], GL_QUERY_RESULT, &elapsed);
+            pending[q] = false;
+            float ms = static_cast<float>(elapsed) / 1.0e6f;
+            smoothedMs = smoothedMs == 0.0f ? ms : smoothedMs * 0.95f + ms * 0.05f;
+        }
+    }
+};
+
+// GPU雨滴模拟 - 变换反馈乒乓缓冲
+// 雨滴状态常驻显存：每步由顶点着色器读取一个缓冲、写入另一个缓冲，CPU只负责提交绘制命令。
+// 落水的雨滴由几何着色器收集到小型撞击缓冲，通过围栏异步回读，用于生成涟漪和声音。
+class GpuRaindropSystem {
+public:
+    static const int IMPACT_CAPACITY = 4096;  // 每步最多记录的撞击数（超出部分丢弃）
+    static const int IMPACT_SLOTS = 3;        // 撞击回读环形缓冲数量，避免CPU等待GPU
+
+    int capacity;
+    int activeCount;        // 当前模拟的雨滴数
+    uint32_t stepIndex;     // 模拟步数，与 seedKey 组合后作为重新生成雨滴的哈希种子
+    uint32_t seedKey;       // 由场景种子派生
+
+    std::vector<glm::vec4> impacts;  // 已回读、尚未被取走的撞击（xyz 位置，w 颜色下标），可能跨多步累积
+    uint32_t impactsGenerated;       // 上次取走的撞击对应的实际落水数（可能大于回读数量）
+    int impactsReadBack;             // 上次取走的撞击数
+
+    GpuRaindropSystem() :
+        capacity(0),
+        activeCount(0),
+        stepIndex(0),
+        seedKey(0),
+        impactsGenerated(0),
+        impactsReadBack(0),
+        current(0),
+        nextSlot(0),
+        pendingGenerated(0) {
+    }
+
+    // 释放GL资源，须在OpenGL上下文销毁前调用
+    void release() {
+        if (capacity == 0) return;
+        glDeleteVertexArrays(2, stateVAO);
+        glDeleteVertexArrays(2, renderVAO);
+        glDeleteBuffers(2, stateVBO);
+        glDeleteBuffers(IMPACT_SLOTS, impactVBO);
+        glDeleteQueries(IMPACT_SLOTS, impactWrittenQuery);
+        glDeleteQueries(IMPACT_SLOTS, impactGeneratedQuery);
+        for (int s = 0; s < IMPACT_SLOTS; s++) {
+            if (impactFence[s]) glDeleteSync(impactFence[s]);
+        }
+        capacity = 0;
+    }
+
+    bool init(int _capacity) {
+        simShader = std::make_unique<Shader>("shaders/raindrop_sim.vert", nullptr, nullptr,
+            std::vector<const char*>{ "outPosLife", "outVelSpan", "outAttrib" });
+        impactShader = std::make_unique<Shader>("shaders/raindrop_impact.vert", "shaders/raindrop_impact.geom", nullptr,
+            std::vector<const char*>{ "impact" });
+        renderShader = std::make_unique<Shader>("shaders/raindrop_gpu.vert", "shaders/raindrop.frag");
+        colorUniforms = renderShader->uniform<glm::vec3>("raindropColors");
+
+        capacity = _capacity;
+        impacts.reserve(IMPACT_CAPACITY * IMPACT_SLOTS);
+        while (glGetError() != GL_NO_ERROR) {} // 清除之前遗留的错误，以便检测显存分配失败
+
+        // 两个状态缓冲全部置零：寿命为 0 的空槽会在第一步被生成
+        std::vector<float> zeros(static_cast<size_t>(capacity) * 12, 0.0f);
+        glGenVertexArrays(2, stateVAO);
+        glGenBuffers(2, stateVBO);
+        for (int b = 0; b < 2; b++) {
+            glBindVertexArray(stateVAO[b]);
+            glBindBuffer(GL_ARRAY_BUFFER, stateVBO[b]);
+            glBufferData(GL_ARRAY_BUFFER, zeros.size() * sizeof(float), zeros.data(), GL_DYNAMIC_COPY);
+            for (int a = 0; a < 3; a++) {
+                glVertexAttribPointer(a, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(a * 4 * sizeof(float)));
+                glEnableVertexAttribArray(a);
+            }
+        }
+        
+        // 渲染用VAO：当前状态 + 另一个缓冲（上一步）的位置，用于固定步长之间的插值
+        glGenVertexArrays(2, renderVAO);
+        for (int b = 0; b < 2; b++) {
+            glBindVertexArray(renderVAO[b]);
+            glBindBuffer(GL_ARRAY_BUFFER, stateVBO[b]);
+            for (int a = 0; a < 3; a++) {
+                glVertexAttribPointer(a, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(a * 4 * sizeof(float)));
+                glEnableVertexAttribArray(a);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, stateVBO[1 - b]);
+            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(3);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        glGenBuffers(IMPACT_SLOTS, impactVBO);
+        glGenQueries(IMPACT_SLOTS, impactWrittenQuery);
+        glGenQueries(IMPACT_SLOTS, impactGeneratedQuery);
+        for (int s = 0; s < IMPACT_SLOTS; s++) {
+            glBindBuffer(GL_ARRAY_BUFFER, impactVBO[s]);
+            glBufferData(GL_ARRAY_BUFFER, IMPACT_CAPACITY * sizeof(glm::vec4), nullptr, GL_STREAM_READ);
+            impactFence[s] = nullptr;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        return glGetError() == GL_NO_ERROR;
+    }
+
+    // 推进一步模拟，并把本步落水的雨滴写入下一个撞击缓冲
+    void simulate(float deltaTime, const glm::vec3& cameraPos, int colorCount) {
+        int source = current;
+        int target = 1 - current;
+
+        // 目标撞击缓冲仍未回读时只能等待（仅在GPU落后多帧时发生）；读出的撞击追加到 impacts，下次取走时一并处理
+        int slot = nextSlot;
+        if (impactFence[slot]) {
+            harvestSlot(slot, true);
+        }
+
+        glEnable(GL_RASTERIZER_DISCARD);
+
+        // 1. 积分：source -> target
+        simShader->use();
+        simShader->setFloat("deltaTime", deltaTime);
+        simShader->setVec3("cameraPos", cameraPos);
+        simShader->setUint("seed", seedKey ^ stepIndex++);
+        simShader->setFloat("waterHeight", WATER_HEIGHT);
+        simShader->setInt("colorCount", colorCount);
+
+        glBindVertexArray(stateVAO[source]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateVBO[target]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, activeCount);
+        glEndTransformFeedback();
+
+        // 2. 撞击收集：target 中标记为落水的雨滴 -> 撞击缓冲
+        impactShader->use();
+        glBindVertexArray(stateVAO[target]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, impactVBO[slot]);
+        glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, impactWrittenQuery[slot]);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, impactGeneratedQuery[slot]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, activeCount);
+        glEndTransformFeedback();
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+        impactFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        current = target;
+        nextSlot = (slot + 1) % IMPACT_SLOTS;
+    }
+
+    // 非阻塞回读：按提交顺序读出所有已完成的撞击缓冲（遇到未完成的即停止），追加到 impacts
+    void harvestImpacts() {
+        // 最早提交的槽位紧跟在下一个写入槽位之后
+        for (int k = 0; k < IMPACT_SLOTS; k++) {
+            int slot = (nextSlot + k) % IMPACT_SLOTS;
+            if (impactFence[slot] && !harvestSlot(slot, false)) break;
+        }
+    }
+
+    // 调用方处理完 impacts 后清空，并记录本次的数量供界面显示
+    void clearImpacts() {
+        impactsGenerated = pendingGenerated;
+        impactsReadBack = static_cast<int>(impacts.size());
+        pendingGenerated = 0;
+        impacts.clear();
+    }
+
+    void render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos,
+                float time, const std::vector<glm::vec3>& colors, bool oitEnabled, float interpolation) {
+        renderShader->use();
+        renderShader->setBool("oitEnabled", oitEnabled);
+        renderShader->setFloat("interpolation", interpolation);
+        renderShader->setMat4("view", view);
+        renderShader->setMat4("projection", projection);
+        renderShader->setVec3("cameraPos", cameraPos);
+        renderShader->setFloat("time", time);
+        for (int i = 0; i < std::min(static_cast<int>(colors.size()), 8); i++) {
+            renderShader->set(colorUniforms[i], colors[i]);
+        }
+
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(renderVAO[current]);
+        glDrawArrays(GL_POINTS, 0, activeCount);
+        glBindVertexArray(0);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+private:
+    std::unique_ptr<Shader> simShader;
+    std::unique_ptr<Shader> impactShader;
+    std::unique_ptr<Shader> renderShader;
+    UniformHandle<glm::vec3> colorUniforms;
+
+    unsigned int stateVAO[2], stateVBO[2];
+    unsigned int renderVAO[2];  // 渲染用：当前状态 + 上一步位置
+    int current;  // 保存最新状态的缓冲
+
+    unsigned int impactVBO[IMPACT_SLOTS];
+    unsigned int impactWrittenQuery[IMPACT_SLOTS];    // 实际写入撞击缓冲的数量
+    unsigned int impactGeneratedQuery[IMPACT_SLOTS];  // 落水总数（包括超出容量被丢弃的）
+    GLsync impactFence[IMPACT_SLOTS];
+    int nextSlot;
+    uint32_t pendingGenerated;  // impacts 中各步的落水总数
+
+    bool harvestSlot(int slot, bool wait) {
+        GLenum status = glClientWaitSync(impactFence[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         wait ? 1000000000ull : 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(impactFence[slot]);
+        impactFence[slot] = nullptr;
+
+        GLuint written = 0, generated = 0;
+        glGetQueryObjectuiv(impactWrittenQuery[slot], GL_QUERY_RESULT, &written);
+        glGetQueryObjectuiv(impactGeneratedQuery[slot], GL_QUERY_RESULT, &generated);
+        pendingGenerated += generated;
+        if (written > 0) {
+            glBindBuffer(GL_ARRAY_BUFFER, impactVBO[slot]);
+            const glm::vec4* data = static_cast<const glm::vec4*>(
+                glMapBufferRange(GL_ARRAY_BUFFER, 0, written * sizeof(glm::vec4), GL_MAP_READ_BIT));
+            if (data) {
+                impacts.insert(impacts.end(), data, data + written);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        return true;
+    }
+};
+
+// 水面高度场 - 覆盖整个池塘的波动方程网格，两张浮点纹理轮流作为输入和输出在GPU上推进
+// 每个纹素存 (当前高度, 上一步高度)，按显式差分 h' = 2h - h_prev + C²∇²h 更新。
+// 撞击以高斯形状的下压脉冲写入，波纹之间的干涉由方程自然产生，开销只取决于网格分辨率。
+class WaveHeightfield {
+public:
+    static constexpr float MAX_COURANT = 0.7f; // 单次迭代的 c·dt/dx 上限，超过时拆成多次迭代
+
+    int resolution;
+    int impulseCount;      // 上一步写入的撞击数
+
+    WaveHeightfield() : resolution(0), impulseCount(0), current(0), emptyVAO(0), impulseVAO(0), impulseVBO(0) {
+        for (int b = 0; b < 2; b++) {
+            stateTexture[b] = 0;
+            stateFBO[b] = 0;
+        }
+    }
+
+    // 释放GL资源，须在OpenGL上下文销毁前调用
+    void release() {
+        if (resolution == 0) return;
+        glDeleteFramebuffers(2, stateFBO);
+        glDeleteTextures(2, stateTexture);
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteVertexArrays(1, &impulseVAO);
+        glDeleteBuffers(1, &impulseVBO);
+        resolution = 0;
+    }
+
+    bool init(int _resolution) {
+        simShader = std::make_unique<Shader>("shaders/oit_resolve.vert", "shaders/wave_sim.frag");
+        impulseShader = std::make_unique<Shader>("shaders/wave_impulse.vert", "shaders/wave_impulse.frag");
+        resolution = _resolution;
+        current = 0;
+        impulses.clear();
+        while (glGetError() != GL_NO_ERROR) {}
+
+        // 两张纹理都从静止水面开始
+        GLint previousFBO;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+        std::vector<float> zeros(static_cast<size_t>(resolution) * resolution * 2, 0.0f);
+        glGenTextures(2, stateTexture);
+        glGenFramebuffers(2, stateFBO);
+        bool complete = true;
+        for (int b = 0; b < 2; b++) {
+            glBindTexture(GL_TEXTURE_2D, stateTexture[b]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, resolution, resolution, 0, GL_RG, GL_FLOAT, zeros.data());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindFramebuffer(GL_FRAMEBUFFER, stateFBO[b]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, stateTexture[b], 0);
+            complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+        glGenVertexArrays(1, &emptyVAO); // 核心模式下绘制必须绑定VAO，全屏三角形不需要顶点属性
+        
+        // 撞击点：每步整体上传
+        glGenVertexArrays(1, &impulseVAO);
+        glGenBuffers(1, &impulseVBO);
+        glBindVertexArray(impulseVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, impulseVBO);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        return complete && glGetError() == GL_NO_ERROR;
+    }
+
+    // 在世界坐标处加入一次下压脉冲（下一次 simulate 时写入，数量不设上限）
+    void addImpulse(const glm::vec3& position, float strength, float radius) {
+        // 半径不足一个半纹素时高斯会落在纹素之间，按网格间距放宽
+        float uvRadius = std::max(radius / POND_SIZE, 1.5f / resolution);
+        impulses.push_back(glm::vec4(position.x / POND_SIZE + 0.5f, position.z / POND_SIZE + 0.5f,
+                                     strength, uvRadius));
+    }
+
+    // 推进 deltaTime；waveSpeed 为世界单位/秒，damping 为每秒的衰减率
+    void simulate(float deltaTime, float waveSpeed, float damping) {
+        float cellSize = POND_SIZE / resolution;
+        float courant = waveSpeed * deltaTime / cellSize;
+        int iterations = std::max(1, static_cast<int>(std::ceil(courant / MAX_COURANT)));
+        courant /= iterations;
+
+        GLint previousFBO;
+        GLint viewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glViewport(0, 0, resolution, resolution);
+
+        simShader->use();
+        simShader->setInt("state", 0);
+        simShader->setFloat("courant2", courant * courant);
+        simShader->setFloat("damping", std::exp(-damping * deltaTime / iterations));
+        glActiveTexture(GL_TEXTURE0);
+        impulseCount = static_cast<int>(impulses.size());
+        for (int it = 0; it < iterations; it++) {
+            simShader->use();
+            glBindVertexArray(emptyVAO);
+            glBindFramebuffer(GL_FRAMEBUFFER, stateFBO[1 - current]);
+            glBindTexture(GL_TEXTURE_2D, stateTexture[current]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            current = 1 - current;
+            
+            // 脉冲只在第一次迭代后叠加：每个撞击一个点，开销与撞击数成正比，与网格分辨率无关
+            if (it == 0 && impulseCount > 0) {
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glBindBuffer(GL_ARRAY_BUFFER, impulseVBO);
+                glBufferData(GL_ARRAY_BUFFER, impulses.size() * sizeof(glm::vec4), impulses.data(), GL_STREAM_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                impulseShader->use();
+                impulseShader->setFloat("resolution", static_cast<float>(resolution));
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                glEnable(GL_PROGRAM_POINT_SIZE);
+                glBindVertexArray(impulseVAO);
+                glDrawArrays(GL_POINTS, 0, impulseCount);
+                glDisable(GL_PROGRAM_POINT_SIZE);
+                glDisable(GL_BLEND);
+            }
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        if (blend) glEnable(GL_BLEND);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        impulses.clear();
+    }
+
+    // 最新的高度纹理（r 为高度）
+    unsigned int texture() const {
+        return stateTexture[current];
+    }
+
+private:
+    int current;
+    unsigned int stateTexture[2];
+    unsigned int stateFBO[2];
+    unsigned int emptyVAO;
+    unsigned int impulseVAO, impulseVBO;
+    std::unique_ptr<Shader> simShader;
+    std::unique_ptr<Shader> impulseShader;
+    std::vector<glm::vec4> impulses;  // xy 纹理坐标，z 强度，w 半径（纹理坐标）
+};
+
+// 涟漪环形网格缓存 - 同一组同心环按几种分段数各生成一份，按屏幕上的大小选用
+// 每个环是一条索引三角带（内外圈顶点交替），环之间用图元重启分隔；所有细节层次共用一个顶点和索引缓冲。
+// 环数改变时在原缓冲上重新生成，引用这两个缓冲的VAO不需要重新设置。
+class RippleMesh {
+public:
+    static const int LOD_COUNT = 4;
+    static constexpr unsigned int RESTART_INDEX = 0xFFFFFFFFu;
+
+    int rings;
+    int segments[LOD_COUNT];
+    int indexOffset[LOD_COUNT];  // 各层次在索引缓冲中的起点（索引个数）
+    int indexCount[LOD_COUNT];
+    int vertexCount[LOD_COUNT];  // 各层次实际引用的顶点数（每环 (分段数 + 1) * 2）
+
+    RippleMesh() : rings(0), vertexBuffer(0), indexBuffer(0) {
+        const int lodSegments[LOD_COUNT] = { 256, 96, 32, 12 };
+        for (int l = 0; l < LOD_COUNT; l++) {
+            segments[l] = lodSegments[l];
+            indexOffset[l] = indexCount[l] = vertexCount[l] = 0;
+        }
+    }
+
+    void release() {
+        if (vertexBuffer == 0) return;
+        glDeleteBuffers(1, &vertexBuffer);
+        glDeleteBuffers(1, &indexBuffer);
+        vertexBuffer = indexBuffer = 0;
+        rings = 0;
+    }
+
+    // 创建缓冲并绑定到当前VAO：顶点位置为属性 0，索引缓冲记录在VAO中
+    void attach(int _rings) {
+        glGenBuffers(1, &vertexBuffer);
+        glGenBuffers(1, &indexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        rings = 0;
+        ensure(_rings);
+    }
+
+    // 环数与已生成的不同时重新生成所有层次
+    void ensure(int _rings) {
+        if (_rings == rings) return;
+        rings = _rings;
+
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        for (int l = 0; l < LOD_COUNT; l++) {
+            indexOffset[l] = static_cast<int>(indices.size());
+            unsigned int firstVertex = static_cast<unsigned int>(vertices.size() / 3);
+            for (int ring = 0; ring < rings; ring++) {
+                float innerRadius = 0.7f + 0.1f * ring;
+                float outerRadius = 0.9f + 0.1f * ring;
+                if (ring > 0) indices.push_back(RESTART_INDEX);
+                // 首尾各一对顶点（角度 0 和 2π），纹理和法线无需接缝处理
+                for (int i = 0; i <= segments[l]; i++) {
+                    float theta = 2.0f * glm::pi<float>() * float(i) / float(segments[l]);
+                    float c = cos(theta);
+                    float s = sin(theta);
+                    unsigned int vertex = static_cast<unsigned int>(vertices.size() / 3);
+                    vertices.insert(vertices.end(), { innerRadius * c, 0.0f, innerRadius * s,
+                                                      outerRadius * c, 0.0f, outerRadius * s });
+                    indices.push_back(vertex);
+                    indices.push_back(vertex + 1);
+                }
+            }
+            indexCount[l] = static_cast<int>(indices.size()) - indexOffset[l];
+            vertexCount[l] = static_cast<int>(vertices.size() / 3 - firstVertex);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // 索引缓冲是VAO状态，直接经由复制目标上传，避免改动当前VAO
+        glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    // 按投影到屏幕上的半径（像素）选择层次：每段弧长约 4 像素，取满足要求的最粗层次
+    int lodFor(float screenRadius) const {
+        float wantedSegments = 2.0f * glm::pi<float>() * screenRadius / 4.0f;
+        for (int l = LOD_COUNT - 1; l > 0; l--) {
+            if (segments[l] >= wantedSegments) return l;
+        }
+        return 0;
+    }
+
+private:
+    unsigned int vertexBuffer;
+    unsigned int indexBuffer;
+};
+
+// 涟漪句柄 - 槽位加代数，涟漪删除后槽位的代数加一，旧句柄随即失效
+struct RippleHandle {
+    int slot = -1;
+    uint32_t generation = 0;
+};
+
+// 水面涟漪池 - 固定容量的SoA存储，存活涟漪紧密排列在 [0, count)
+// 删除时用最后一个涟漪填补空位，不移动其余数据；槽位经空闲列表复用，调度器等其他系统通过句柄引用涟漪。
+// 半径和透明度都是 lifetime 的解析函数，消失时刻在生成时即可确定（见 deathTime）。
+class RipplePool {
+public:
+    int capacity;
+    int count;
+
+    // 中心（高度固定为略高于水面）与外观
+    std::vector<float> posX, posZ;
+    std::vector<glm::vec3> color;
+    // 每步更新的状态；previous* 为上一步的值，渲染时插值
+    std::vector<float> radius, previousRadius;
+    std::vector<float> opacity, previousOpacity;
+    std::vector<float> thickness;
+    std::vector<float> waveHeight;   // 水面高度偏移
+    std::vector<float> lifetime;
+    // 生成时确定的参数
+    std::vector<float> startRadius, maxRadius, growthRate, maxLifetime;
+    std::vector<float> pulseFrequency, pulseAmplitude;
+    std::vector<int> slotOf;         // 下标 -> 槽位
+
+    RipplePool() : capacity(0), count(0) {}
+
+    // 对每个按涟漪下标存放的数组执行 f（新增字段只需在这里登记）
+    template <typename F>
+    void forEachArray(F f) {
+        f(posX); f(posZ);
+        f(color);
+        f(radius); f(previousRadius);
+        f(opacity); f(previousOpacity);
+        f(thickness);
+        f(waveHeight);
+        f(lifetime);
+        f(startRadius); f(maxRadius); f(growthRate); f(maxLifetime);
+        f(pulseFrequency); f(pulseAmplitude);
+        f(slotOf);
+    }
+
+    // 一次性分配全部存储
+    void init(int _capacity) {
+        capacity = _capacity;
+        count = 0;
+        forEachArray([this](auto& array) { array.resize(capacity); });
+        indexOfSlot.assign(capacity, -1);
+        generationOfSlot.assign(capacity, 0);
+        freeSlots.resize(capacity);
+        for (int slot = 0; slot < capacity; slot++) {
+            freeSlots[slot] = capacity - 1 - slot; // 先取小槽位
+        }
+    }
+
+    bool full() const {
+        return count >= capacity;
+    }
+
+    // 在末尾生成一个涟漪，返回其下标（调用前需检查 full）
+    int add(const glm::vec3& position, const glm::vec3& rippleColor, CounterRng& rng) {
+        int i = count++;
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        slotOf[i] = slot;
+        indexOfSlot[slot] = i;
+
+        posX[i] = position.x;
+        posZ[i] = position.z;
+        color[i] = rippleColor;
+        radius[i] = 3.0f; // 更大的初始半径
+        startRadius[i] = radius[i];
+        maxRadius[i] = 80.0f + rng.uniform() * 120.0f; // 超大涟漪
+        thickness[i] = 0.6f + rng.uniform() * 1.2f; // 更厚的线条
+        opacity[i] = 1.0f; // 完全不透明开始
+        growthRate[i] = 15.0f + rng.uniform() * 25.0f; // 超快扩散
+        lifetime[i] = 0.0f;
+        maxLifetime[i] = 6.0f + rng.uniform() * 4.0f; // 更长寿命
+        pulseFrequency[i] = 3.0f + rng.uniform() * 4.0f;
+        pulseAmplitude[i] = 0.3f + rng.uniform() * 0.4f;
+        waveHeight[i] = 0.1f + rng.uniform() * 0.2f;
+        previousRadius[i] = radius[i];
+        previousOpacity[i] = opacity[i];
+        return i;
+    }
+
+    // 删除下标 i 的涟漪：最后一个涟漪移入空位，槽位代数加一后回收
+    void remove(int i) {
+        int slot = slotOf[i];
+        int last = --count;
+        if (i != last) {
+            forEachArray([i, last](auto& array) { array[i] = array[last]; });
+            indexOfSlot[slotOf[i]] = i;
+        }
+        indexOfSlot[slot] = -1;
+        generationOfSlot[slot]++;
+        freeSlots.push_back(slot);
+    }
+
+    RippleHandle handle(int i) const {
+        RippleHandle h;
+        h.slot = slotOf[i];
+        h.generation = generationOfSlot[h.slot];
+        return h;
+    }
+
+    // 句柄指向的涟漪已删除（或槽位被复用）时返回 -1
+    int indexOf(const RippleHandle& h) const {
+        if (h.slot < 0 || h.slot >= capacity || generationOfSlot[h.slot] != h.generation) return -1;
+        return indexOfSlot[h.slot];
+    }
+
+    // 更新 [begin, end) 区间：每个字段按数组连续处理
+    void update(int begin, int end, float deltaTime) {
+        for (int i = begin; i < end; i++) {
+            previousRadius[i] = radius[i];
+            previousOpacity[i] = opacity[i];
+            lifetime[i] += deltaTime;
+        }
+        for (int i = begin; i < end; i++) {
+            float progress = lifetime[i] / maxLifetime[i];
+            // 扩散速度随 progress 线性减慢到一半：r = r0 + g (t - t² / 4T)
+            radius[i] = startRadius[i] + growthRate[i] * lifetime[i] * (1.0f - progress * 0.25f);
+            // 改进的透明度衰减 - 更慢更自然
+            opacity[i] = 1.0f - progress * progress;
+        }
+        for (int i = begin; i < end; i++) {
+            float progress = lifetime[i] / maxLifetime[i];
+            float phase = lifetime[i] * pulseFrequency[i];
+            // 动态厚度变化
+            thickness[i] = 0.3f + 0.4f * sinf(phase) * pulseAmplitude[i];
+            // 波浪高度衰减
+            waveHeight[i] = (0.1f + 0.2f * sinf(phase * 1.2f)) * (1.0f - progress);
+        }
+    }
+
+    // 半径达到 maxRadius 或透明度降到 0.02 以下（progress² >= 0.98）中较早的时刻
+    float deathTime(int i) const {
+        float fadeTime = maxLifetime[i] * std::sqrt(0.98f);
+        float span = (maxRadius[i] - startRadius[i]) / (growthRate[i] * maxLifetime[i]);
+        if (span >= 1.0f) return fadeTime; // 半径最大只到 r0 + gT
+        float growTime = 2.0f * maxLifetime[i] * (1.0f - std::sqrt(1.0f - span));
+        return std::min(fadeTime, growTime);
+    }
+
+    glm::vec3 position(int i) const {
+        return glm::vec3(posX[i], WATER_HEIGHT + 0.02f, posZ[i]); // 稍高于水面以确保可见
+    }
+
+    float interpolatedRadius(int i, float alpha) const {
+        return previousRadius[i] + (radius[i] - previousRadius[i]) * alpha;
+    }
+
+    // 涟漪网格最外层环的半径：最外环位于 0.8 + 0.1 * rings 倍半径处，外层再放大 1.2 倍（与 ripple.vert 一致）
+    float outerRadius(int i, float alpha, int rings) const {
+        return interpolatedRadius(i, alpha) * (0.8f + 0.1f * rings) * 1.2f;
+    }
+
+    float interpolatedOpacity(int i, float alpha) const {
+        return previousOpacity[i] + (opacity[i] - previousOpacity[i]) * alpha;
+    }
+
+private:
+    std::vector<int> indexOfSlot;          // 槽位 -> 当前下标（-1 表示空闲）
+    std::vector<uint32_t> generationOfSlot;
+    std::vector<int> freeSlots;
+};
+
+// 均匀网格 - 覆盖 POND_SIZE 见方的水面，按 xz 坐标把对象放进格子
+// 每个格子是一条单向链表（cellHead / next），插入 O(1)，每步整体重建也只是线性开销。
+// 半径查询只遍历与查询圆相交的格子；池塘外的坐标归入最近的边缘格子。
+class SpatialGrid {
+public:
+    void init(float worldSize, int resolution) {
+        cellsPerSide = resolution;
+        origin = -worldSize * 0.5f;
+        inverseCellSize = resolution / worldSize;
+        cellHead.assign(static_cast<size_t>(resolution) * resolution, -1);
+        cellCounts.assign(cellHead.size(), 0);
+        clear();
+    }
+
+    void clear() {
+        std::fill(cellHead.begin(), cellHead.end(), -1);
+        std::fill(cellCounts.begin(), cellCounts.end(), 0);
+        next.clear();
+        itemX.clear();
+        itemZ.clear();
+    }
+
+    // 插入对象并返回所在格子；item 为调用方的下标，必须按 0, 1, 2 ... 连续插入
+    int insert(float x, float z) {
+        int item = static_cast<int>(next.size());
+        int cell = cellOf(x, z);
+        next.push_back(cellHead[cell]);
+        itemX.push_back(x);
+        itemZ.push_back(z);
+        cellHead[cell] = item;
+        cellCounts[cell]++;
+        return cell;
+    }
+
+    int cellOf(float x, float z) const {
+        return cellCoord(z) * cellsPerSide + cellCoord(x);
+    }
+
+    int cellCount(int cell) const {
+        return cellCounts[cell];
+    }
+
+    int cellsPerAxis() const {
+        return cellsPerSide;
+    }
+
+    float cellSize() const {
+        return 1.0f / inverseCellSize;
+    }
+
+    // 格子中心的 (x, z)
+    glm::vec2 cellCenter(int cell) const {
+        return glm::vec2(origin + (cell % cellsPerSide + 0.5f) * cellSize(),
+                         origin + (cell / cellsPerSide + 0.5f) * cellSize());
+    }
+
+    int size() const {
+        return static_cast<int>(next.size());
+    }
+
+    // 对与 (x, z) 距离不超过 radius 的每个对象调用 fn(item)
+    template <typename F>
+    void queryRadius(float x, float z, float radius, F&& fn) const {
+        int minX = cellCoord(x - radius), maxX = cellCoord(x + radius);
+        int minZ = cellCoord(z - radius), maxZ = cellCoord(z + radius);
+        float radiusSq = radius * radius;
+        for (int cz = minZ; cz <= maxZ; cz++) {
+            for (int cx = minX; cx <= maxX; cx++) {
+                for (int item = cellHead[cz * cellsPerSide + cx]; item >= 0; item = next[item]) {
+                    float dx = itemX[item] - x;
+                    float dz = itemZ[item] - z;
+                    if (dx * dx + dz * dz <= radiusSq) fn(item);
+                }
+            }
+        }
+    }
+
+private:
+    int cellsPerSide = 0;
+    float origin = 0.0f;
+    float inverseCellSize = 0.0f;
+    std::vector<int> cellHead;    // 每个格子链表的第一个对象，-1 表示空
+    std::vector<int> cellCounts;
+    std::vector<int> next;        // 同一格子中的下一个对象
+    std::vector<float> itemX, itemZ;
+
+    int cellCoord(float v) const {
+        int c = static_cast<int>(std::floor((v - origin) * inverseCellSize));
+        return std::min(std::max(c, 0), cellsPerSide - 1);
+    }
+};
+
+// FFT 海浪（Tessendorf）
+// 在 N×N 的频域网格上用 Phillips 谱生成初始振幅 h0(k)，每帧按色散关系 ω = sqrt(g|k|) 推进相位，
+// 再用二维逆 FFT 得到一个可平铺的波块（边长 patchSize）上的高度和 x/z 斜率。
+// 高度和 x 斜率都是实数场，合成一个复数场 H + i·Sx 只做一次逆变换；z 斜率单独一次。
+// 行和列的一维 FFT 分块交给任务系统并行执行，蝶形运算使用所选的SIMD实现。
+class OceanFft {
+public:
+    static constexpr float GRAVITY = 9.81f;
+    static const int ROW_CHUNK = 16;   // 每个任务处理的行/列数
+
+    int resolution;
+    float patchSize;
+    std::vector<float> texels;         // RGBA：高度、x 斜率、z 斜率、0（按行存放，供上传）
+
+    // 各阶段耗时（平滑，毫秒）
+    float spectrumMs, rowsMs, columnsMs, packMs;
+
+    OceanFft() : resolution(0), patchSize(0.0f), spectrumMs(0.0f), rowsMs(0.0f), columnsMs(0.0f), packMs(0.0f), log2N(0) {}
+
+    // 生成初始谱；高度按均方根 rmsHeight 归一化，波形与分辨率和风速无关地保持相近的幅度
+    // 按行分块并行，第 z 行使用子流 rng.split(z)，结果与线程数和分块方式无关
+    void init(int _resolution, float _patchSize, float windSpeed, const glm::vec2& windDirection, float rmsHeight,
+              const CounterRng& rng, JobSystem& jobs) {
+        resolution = _resolution;
+        patchSize = _patchSize;
+        int n = resolution;
+        log2N = 0;
+        while ((1 << log2N) < n) log2N++;
+        size_t cells = static_cast<size_t>(n) * n;
+
+        h0Re.assign(cells, 0.0f); h0Im.assign(cells, 0.0f);
+        h0ConjRe.assign(cells, 0.0f); h0ConjIm.assign(cells, 0.0f);
+        omega.assign(cells, 0.0f);
+        kx.assign(cells, 0.0f); kz.assign(cells, 0.0f);
+        heightRe.assign(cells, 0.0f); heightIm.assign(cells, 0.0f);
+        slopeRe.assign(cells, 0.0f); slopeIm.assign(cells, 0.0f);
+        texels.assign(cells * 4, 0.0f);
+
+        // Phillips 谱：P(k) = exp(-1/(kL)²) / k⁴ · |k̂·ŵ|² · exp(-(k l)²)，L = V²/g，l 抑制过短的波
+        glm::vec2 wind = glm::normalize(windDirection);
+        float largestWave = windSpeed * windSpeed / GRAVITY;
+        float smallestWave = largestWave * 0.001f;
+        std::vector<float> amplitudeRe(cells), amplitudeIm(cells);
+        std::vector<double> rowEnergy(n, 0.0);
+        jobs.parallelFor(n, ROW_CHUNK, [&](int begin, int end, int) {
+            for (int z = begin; z < end; z++) {
+                CounterRng rowRng = rng.split(z);
+                for (int x = 0; x < n; x++) {
+                    size_t i = static_cast<size_t>(z) * n + x;
+                    glm::vec2 k(2.0f * glm::pi<float>() * (x - n / 2) / patchSize,
+                                2.0f * glm::pi<float>() * (z - n / 2) / patchSize);
+                    float k2 = glm::dot(k, k);
+                    // Box-Muller：两个独立的标准正态数
+                    float u1 = std::max(rowRng.uniform(), 1e-7f);
+                    float u2 = rowRng.uniform();
+                    float r = std::sqrt(-2.0f * std::log(u1));
+                    float phillips = 0.0f;
+                    // 奈奎斯特行列（x = 0 或 z = 0）没有对称的 -k，保持为零，否则合成场的虚部会混入高度
+                    if (k2 > 0.0f && x > 0 && z > 0) {
+                        float alignment = glm::dot(k / std::sqrt(k2), wind);
+                        phillips = std::exp(-1.0f / (k2 * largestWave * largestWave)) / (k2 * k2)
+                                 * alignment * alignment * std::exp(-k2 * smallestWave * smallestWave);
+                        if (alignment < 0.0f) phillips *= 0.07f; // 逆风方向的波大幅减弱
+                    }
+                    float amplitude = std::sqrt(phillips * 0.5f);
+                    amplitudeRe[i] = r * std::cos(2.0f * glm::pi<float>() * u2) * amplitude;
+                    amplitudeIm[i] = r * std::sin(2.0f * glm::pi<float>() * u2) * amplitude;
+                    kx[i] = k.x;
+                    kz[i] = k.y;
+                    omega[i] = std::sqrt(GRAVITY * std::sqrt(k2));
+                    rowEnergy[z] += amplitudeRe[i] * amplitudeRe[i] + amplitudeIm[i] * amplitudeIm[i];
+                }
+            }
+        });
+        // 按行顺序求和，保持逐位可复现
+        double energy = 0.0;
+        for (int z = 0; z < n; z++) energy += rowEnergy[z];
+
+        // 均方高度 = Σ(|h0(k)|² + |h0(-k)|²) = 2Σ|h0|²
+        float scale = energy > 0.0 ? rmsHeight / static_cast<float>(std::sqrt(2.0 * energy)) : 0.0f;
+        for (int z = 0; z < n; z++) {
+            for (int x = 0; x < n; x++) {
+                size_t i = static_cast<size_t>(z) * n + x;
+                size_t mirrored = static_cast<size_t>((n - z) % n) * n + (n - x) % n; // -k
+                h0Re[i] = amplitudeRe[i] * scale;
+                h0Im[i] = amplitudeIm[i] * scale;
+                h0ConjRe[i] = amplitudeRe[mirrored] * scale;
+                h0ConjIm[i] = -amplitudeIm[mirrored] * scale;
+            }
+        }
+
+        // 位反转表和逆变换旋转因子 e^{+2πij/size}（各级依次存放，第 s 级从 (1 << s) - 1 开始）
+        bitReverse.resize(n);
+        for (int i = 0; i < n; i++) {
+            int reversed = 0;
+            for (int b = 0; b < log2N; b++) {
+                if (i & (1 << b)) reversed |= 1 << (log2N - 1 - b);
             }
+            bitReverse[i] = reversed;
         }
-        else {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success) {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        twiddleRe.assign(std::max(n - 1, 1), 1.0f);
+        twiddleIm.assign(std::max(n - 1, 1), 0.0f);
+        for (int half = 1; half < n; half *= 2) {
+            for (int j = 0; j < half; j++) {
+                double angle = glm::pi<double>() * j / half;
+                twiddleRe[half - 1 + j] = static_cast<float>(std::cos(angle));
+                twiddleIm[half - 1 + j] = static_cast<float>(std::sin(angle));
             }
         }
     }
-};
 
-// Forward declaration for application class
-class RainSimulation;
+    // 计算时刻 time 的高度和斜率，结果写入 texels
+    void evaluate(float time, JobSystem& jobs, FftButterflyKernel butterflies) {
+        int n = resolution;
+        auto start = std::chrono::high_resolution_clock::now();
 
-// Enhanced Raindrop class with trail effect
-class Raindrop {
-public:
-    glm::vec3 position;
-    glm::vec3 velocity;
-    glm::vec3 color;
-    float size;
-    float lifespan;
-    float lifetime;
-    bool visible;
-    int state; // 0: falling, 1: entered water, 2: disappeared
-    RainSimulation* simulation;
-    float brightness;
-    float twinkleSpeed;
-    
-    // 新增拖尾效果相关属性
-    std::vector<glm::vec3> trailPositions;  // 拖尾位置历史
-    std::vector<float> trailAlphas;         // 拖尾透明度历史
-    int maxTrailLength;                     // 最大拖尾长度
-    float trailUpdateTime;                  // 拖尾更新计时器
-    float trailUpdateInterval;              // 拖尾更新间隔
-    float distanceFromCamera;               // 距离摄像机的距离
-    float layerDepth;                       // 层次深度 (0=近, 1=远)
-
-    Raindrop() : 
-        position(0.0f),
-        velocity(0.0f),
-        color(1.0f),
-        size(0.1f),
-        lifespan(3.0f),
-        lifetime(0.0f),
-        visible(true),
-        state(0),
-        simulation(nullptr),
-        brightness(1.0f),
-        twinkleSpeed(0.0f),
-        maxTrailLength(8),
-        trailUpdateTime(0.0f),
-        trailUpdateInterval(0.05f),
-        distanceFromCamera(0.0f),
-        layerDepth(0.0f) {
-        trailPositions.reserve(maxTrailLength);
-        trailAlphas.reserve(maxTrailLength);
-    }
-
-    void init(const glm::vec3& _position, const glm::vec3& _color, RainSimulation* _simulation) {
-        position = _position;
-        color = _color;
-        simulation = _simulation;
-        
-        // 根据距离调整雨滴属性 - 实现层次感
-        distanceFromCamera = glm::length(_position - glm::vec3(0.0f, 60.0f, 120.0f)); // 假设摄像机位置
-        layerDepth = std::min(distanceFromCamera / 200.0f, 1.0f); // 0-1范围
-        
-        velocity = glm::vec3(
-            (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 1.0f, // 增加水平运动
-            -3.0f - static_cast<float>(rand()) / RAND_MAX * 5.0f,  // 更大的垂直速度变化
-            (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 1.0f
-        );
-        
-        // 近处雨滴更大更慢，远处雨滴更小更快
-        size = (2.0f - layerDepth) * (1.0f + static_cast<float>(rand()) / RAND_MAX * 2.0f);
-        velocity.y *= 0.7f + layerDepth * 0.6f; // 远处雨滴下落更快
-        
-        lifespan = 4.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
-        lifetime = 0.0f;
-        visible = true;
-        state = 0;
-        brightness = 0.8f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
-        twinkleSpeed = 1.0f + static_cast<float>(rand()) / RAND_MAX * 5.0f;
-        
-        // 初始化拖尾系统
-        maxTrailLength = 4 + static_cast<int>((1.0f - layerDepth) * 8); // 近处拖尾更长
-        trailUpdateInterval = 0.03f + layerDepth * 0.02f; // 远处更新更快
-        trailPositions.clear();
-        trailAlphas.clear();
-        trailUpdateTime = 0.0f;
+        // h(k, t) = h0(k) e^{iωt} + conj(h0(-k)) e^{-iωt}；Sx = i kx h，Sz = i kz h
+        jobs.parallelFor(n, ROW_CHUNK, [&](int begin, int end, int) {
+            for (size_t i = static_cast<size_t>(begin) * n; i < static_cast<size_t>(end) * n; i++) {
+                float c = std::cos(omega[i] * time);
+                float s = std::sin(omega[i] * time);
+                float hr = (h0Re[i] + h0ConjRe[i]) * c - (h0Im[i] - h0ConjIm[i]) * s;
+                float hi = (h0Im[i] + h0ConjIm[i]) * c + (h0Re[i] - h0ConjRe[i]) * s;
+                // H + i·Sx = H + i·(i kx H) = (1 - kx) H
+                heightRe[i] = hr - kx[i] * hr;
+                heightIm[i] = hi - kx[i] * hi;
+                slopeRe[i] = -kz[i] * hi;
+                slopeIm[i] = kz[i] * hr;
+            }
+        });
+        auto spectrumEnd = std::chrono::high_resolution_clock::now();
+
+        transformLines(jobs, butterflies, 1, n);   // 行
+        auto rowsEnd = std::chrono::high_resolution_clock::now();
+        transformLines(jobs, butterflies, n, 1);   // 列
+        auto columnsEnd = std::chrono::high_resolution_clock::now();
+
+        // 频域下标以 N/2 为中心，空间域结果需乘 (-1)^(x+z)
+        jobs.parallelFor(n, ROW_CHUNK, [&](int begin, int end, int) {
+            for (int z = begin; z < end; z++) {
+                for (int x = 0; x < n; x++) {
+                    size_t i = static_cast<size_t>(z) * n + x;
+                    float sign = ((x + z) & 1) ? -1.0f : 1.0f;
+                    texels[i * 4 + 0] = heightRe[i] * sign;
+                    texels[i * 4 + 1] = heightIm[i] * sign;
+                    texels[i * 4 + 2] = slopeRe[i] * sign;
+                    texels[i * 4 + 3] = 0.0f;
+                }
+            }
+        });
+        auto packEnd = std::chrono::high_resolution_clock::now();
+
+        smooth(spectrumMs, start, spectrumEnd);
+        smooth(rowsMs, spectrumEnd, rowsEnd);
+        smooth(columnsMs, rowsEnd, columnsEnd);
+        smooth(packMs, columnsEnd, packEnd);
     }
 
-    bool update(float deltaTime);  // Declaration, implemented after RainSimulation class
+private:
+    int log2N;
+    std::vector<float> h0Re, h0Im;          // h0(k)
+    std::vector<float> h0ConjRe, h0ConjIm;  // conj(h0(-k))
+    std::vector<float> omega, kx, kz;
+    std::vector<float> heightRe, heightIm;  // H + i·Sx（变换后为 高度 + i·x 斜率）
+    std::vector<float> slopeRe, slopeIm;    // Sz
+    std::vector<int> bitReverse;
+    std::vector<float> twiddleRe, twiddleIm;
+    std::vector<float> scratch;             // 每个任务块一段 2N 的临时行
 
-    bool isDead() const {
-        return state > 1 || lifetime > lifespan;
+    static void smooth(float& value, std::chrono::high_resolution_clock::time_point begin,
+                       std::chrono::high_resolution_clock::time_point end) {
+        float ms = std::chrono::duration<float, std::milli>(end - begin).count();
+        value = value == 0.0f ? ms : value * 0.95f + ms * 0.05f;
     }
-    
-    // 更新拖尾效果
-    void updateTrail(float deltaTime) {
-        trailUpdateTime += deltaTime;
-        
-        if (trailUpdateTime >= trailUpdateInterval) {
-            // 添加当前位置到拖尾
-            trailPositions.insert(trailPositions.begin(), position);
-            trailAlphas.insert(trailAlphas.begin(), brightness);
-            
-            // 保持拖尾长度
-            if (trailPositions.size() > maxTrailLength) {
-                trailPositions.resize(maxTrailLength);
-                trailAlphas.resize(maxTrailLength);
+
+    // 对两个场的所有行（stride = 1，lineStep = N）或所有列（stride = N，lineStep = 1）做一维逆 FFT：
+    // 按位反转顺序取到连续的临时行，逐级蝶形运算，再写回
+    void transformLines(JobSystem& jobs, FftButterflyKernel butterflies, int lineStep, int stride) {
+        int n = resolution;
+        int chunkCount = (n + ROW_CHUNK - 1) / ROW_CHUNK;
+        scratch.resize(static_cast<size_t>(chunkCount) * n * 2);
+        jobs.parallelFor(n, ROW_CHUNK, [&](int begin, int end, int chunk) {
+            float* re = scratch.data() + static_cast<size_t>(chunk) * n * 2;
+            float* im = re + n;
+            for (int line = begin; line < end; line++) {
+                size_t base = static_cast<size_t>(line) * lineStep;
+                for (int field = 0; field < 2; field++) {
+                    float* dataRe = field == 0 ? heightRe.data() : slopeRe.data();
+                    float* dataIm = field == 0 ? heightIm.data() : slopeIm.data();
+                    for (int i = 0; i < n; i++) {
+                        size_t source = base + static_cast<size_t>(bitReverse[i]) * stride;
+                        re[i] = dataRe[source];
+                        im[i] = dataIm[source];
+                    }
+                    for (int half = 1; half < n; half *= 2) {
+                        for (int group = 0; group < n; group += 2 * half) {
+                            butterflies(re + group, im + group, twiddleRe.data() + half - 1, twiddleIm.data() + half - 1, half);
+                        }
+                    }
+                    for (int i = 0; i < n; i++) {
+                        size_t target = base + static_cast<size_t>(i) * stride;
+                        dataRe[target] = re[i];
+                        dataIm[target] = im[i];
+                    }
+                }
             }
-            
-            trailUpdateTime = 0.0f;
-        }
-        
-        // 更新拖尾透明度衰减
-        for (int i = 0; i < trailAlphas.size(); i++) {
-            float trailFactor = 1.0f - (float(i) / maxTrailLength);
-            trailAlphas[i] *= 0.98f; // 逐渐衰减
-        }
+        });
     }
 };
 
-// Water ripple class - 优化涟漪渲染
-class WaterRipple {
+// 预烘焙的水面波形图集
+// 叠加正弦波（water.vert 的五层起伏、water.frag 的法线扰动）的空间频率都是 0.01 的整数倍，在边长 200π 的方块上可平铺；
+// 时间频率分别是 0.18 和 0.5 的整数倍，分别以 2π/0.18 秒和 4π 秒精确循环。
+// 启动时把一个循环按时间等分采样为纹理数组的各层，着色器在相邻两层之间插值，不再逐顶点/逐片元计算三角函数。
+class WaveAtlas {
 public:
-    glm::vec3 position;
-    glm::vec3 color;
-    float radius;
-    float maxRadius;
-    float thickness;
-    float opacity;
-    float growthRate;
-    float lifetime;
-    float maxLifetime;
-    float pulseFrequency;
-    float pulseAmplitude;
-    float waveHeight;  // 新增：水面高度偏移
-    
-    WaterRipple() : 
-        position(0.0f),
-        color(1.0f),
-        radius(0.5f),
-        maxRadius(5.0f),
-        thickness(0.2f),
-        opacity(0.8f),
-        growthRate(2.0f),
-        lifetime(0.0f),
-        maxLifetime(2.0f),
-        pulseFrequency(0.0f),
-        pulseAmplitude(0.0f),
-        waveHeight(0.0f) {
+    static constexpr float TILE = 628.318531f;           // 200π
+    static const int SURFACE_SIZE = 256;                 // 起伏：高度和 x/z 斜率（单位波浪强度）
+    static const int SURFACE_LAYERS = 128;
+    static constexpr float SURFACE_PERIOD = 34.906585f;  // 2π / 0.18
+    static const int DETAIL_SIZE = 128;                  // 片元法线扰动（频率较低，分辨率减半）
+    static const int DETAIL_LAYERS = 64;
+    static constexpr float DETAIL_PERIOD = 12.566371f;   // 4π
+    // 归一化到 [-1, 1] 后存为 8 位无符号：高度和斜率按各层振幅之和取范围
+    static constexpr float HEIGHT_RANGE = 2.2f;
+    static constexpr float SLOPE_RANGE = 0.36f;
+    static constexpr float DETAIL_RANGE = 0.05f;
+
+    unsigned int surfaceTexture = 0, detailTexture = 0;
+    float bakeMs = 0.0f;
+
+    // 各层互不依赖，按层分块并行
+    void bake(JobSystem& jobs, float waveSpeed) {
+        auto start = std::chrono::high_resolution_clock::now();
+        surfaceTexels.resize(static_cast<size_t>(SURFACE_SIZE) * SURFACE_SIZE * SURFACE_LAYERS * 4);
+        detailTexels.resize(static_cast<size_t>(DETAIL_SIZE) * DETAIL_SIZE * DETAIL_LAYERS * 2);
+        jobs.parallelFor(SURFACE_LAYERS, 4, [&](int begin, int end, int) {
+            for (int layer = begin; layer < end; layer++) bakeSurfaceLayer(layer, waveSpeed);
+        });
+        jobs.parallelFor(DETAIL_LAYERS, 4, [&](int begin, int end, int) {
+            for (int layer = begin; layer < end; layer++) bakeDetailLayer(layer);
+        });
+        
+        release();
+        surfaceTexture = createArray(GL_RGBA8, GL_RGBA, SURFACE_SIZE, SURFACE_LAYERS, surfaceTexels.data(), false);
+        detailTexture = createArray(GL_RG8, GL_RG, DETAIL_SIZE, DETAIL_LAYERS, detailTexels.data(), true);
+        std::vector<uint8_t>().swap(surfaceTexels);
+        std::vector<uint8_t>().swap(detailTexels);
+        bakeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
     }
-    
-    void init(const glm::vec3& _position, const glm::vec3& _color) {
-        position = _position;
-        position.y = WATER_HEIGHT + 0.02f; // 稍高于水面以确保可见
-        color = _color;
-        radius = 3.0f; // 更大的初始半径
-        maxRadius = 80.0f + static_cast<float>(rand()) / RAND_MAX * 120.0f; // 超大涟漪
-        thickness = 0.6f + static_cast<float>(rand()) / RAND_MAX * 1.2f; // 更厚的线条
-        opacity = 1.0f; // 完全不透明开始
-        growthRate = 15.0f + static_cast<float>(rand()) / RAND_MAX * 25.0f; // 超快扩散
-        lifetime = 0.0f;
-        maxLifetime = 6.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f; // 更长寿命
-        pulseFrequency = 3.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
-        pulseAmplitude = 0.3f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
-        waveHeight = 0.1f + static_cast<float>(rand()) / RAND_MAX * 0.2f;
+
+    void release() {
+        glDeleteTextures(1, &surfaceTexture);
+        glDeleteTextures(1, &detailTexture);
+        surfaceTexture = detailTexture = 0;
     }
-    
-    bool update(float deltaTime) {
-        lifetime += deltaTime;
-        
-        float progress = lifetime / maxLifetime;
-        float growthFactor = 1.0f - progress * 0.5f; // 更慢的减速
-        radius += growthRate * deltaTime * growthFactor;
-        
-        // 动态厚度变化
-        thickness = 0.3f + 0.4f * sinf(lifetime * pulseFrequency) * pulseAmplitude;
-        
-        // 改进的透明度衰减 - 更慢更自然
-        opacity = 1.0f * (1.0f - powf(progress, 2.0f));
-        
-        // 波浪高度衰减
-        waveHeight = (0.1f + 0.2f * sinf(lifetime * pulseFrequency * 1.2f)) * (1.0f - progress);
-        
-        return isDead();
+
+    // 时刻 time 对应的相邻两层和插值系数 (第一层, 第二层, 系数)
+    static glm::vec3 layerBlend(float time, float period, int layers) {
+        float position = static_cast<float>(std::fmod(static_cast<double>(time), static_cast<double>(period)) / period * layers);
+        int first = std::min(static_cast<int>(position), layers - 1);
+        return glm::vec3(static_cast<float>(first), static_cast<float>((first + 1) % layers), position - first);
     }
-    
-    bool isDead() const {
-        return radius >= maxRadius || opacity <= 0.02f || lifetime >= maxLifetime;
+
+private:
+    std::vector<uint8_t> surfaceTexels;
+    std::vector<uint8_t> detailTexels;
+
+    static uint8_t encode(float value, float range) {
+        float normalized = glm::clamp(value / range, -1.0f, 1.0f);
+        return static_cast<uint8_t>(std::lround((normalized * 0.5f + 0.5f) * 255.0f));
     }
-    
-    float getCurrentThickness() const {
-        return thickness;
+
+    // 与 water.vert 的 surfaceHeight 和法线导数相同的五层 sin(ax·x + b·t)·cos(az·z + d·t)；
+    // 每层只在行和列上各算一次三角函数，纹素上只做乘加
+    void bakeSurfaceLayer(int layer, float waveSpeed) {
+        static const float freqX[5] = { 0.08f, 0.15f, 0.25f, 0.4f, 0.6f };
+        static const float freqZ[5] = { 0.08f, 0.12f, 0.22f, 0.35f, 0.55f };
+        static const float speedX[5] = { 1.0f, 1.3f, 1.8f, 2.2f, 2.8f };
+        static const float speedZ[5] = { 0.8f, 1.1f, 1.5f, 2.0f, 2.5f };
+        static const float amplitude[5] = { 1.0f, 0.6f, 0.3f, 0.15f, 0.08f };
+        const int n = SURFACE_SIZE;
+        float time = SURFACE_PERIOD * layer / SURFACE_LAYERS;
+        std::vector<float> sinX(5 * n), cosX(5 * n), sinZ(5 * n), cosZ(5 * n);
+        for (int w = 0; w < 5; w++) {
+            for (int i = 0; i < n; i++) {
+                float p = (i + 0.5f) * TILE / n; // 纹素中心
+                sinX[w * n + i] = std::sin(p * freqX[w] + time * waveSpeed * speedX[w]);
+                cosX[w * n + i] = std::cos(p * freqX[w] + time * waveSpeed * speedX[w]);
+                sinZ[w * n + i] = std::sin(p * freqZ[w] + time * waveSpeed * speedZ[w]);
+                cosZ[w * n + i] = std::cos(p * freqZ[w] + time * waveSpeed * speedZ[w]);
+            }
+        }
+        uint8_t* out = surfaceTexels.data() + static_cast<size_t>(layer) * n * n * 4;
+        for (int z = 0; z < n; z++) {
+            for (int x = 0; x < n; x++) {
+                float height = 0.0f, dx = 0.0f, dz = 0.0f;
+                for (int w = 0; w < 5; w++) {
+                    height += sinX[w * n + x] * cosZ[w * n + z] * amplitude[w];
+                    dx += freqX[w] * cosX[w * n + x] * cosZ[w * n + z] * amplitude[w];
+                    dz -= freqZ[w] * sinX[w * n + x] * sinZ[w * n + z] * amplitude[w];
+                }
+                uint8_t* texel = out + (static_cast<size_t>(z) * n + x) * 4;
+                texel[0] = encode(height, HEIGHT_RANGE);
+                texel[1] = encode(dx, SLOPE_RANGE);
+                texel[2] = encode(dz, SLOPE_RANGE);
+                texel[3] = 255;
+            }
+        }
     }
-    
-    float getCurrentWaveHeight() const {
-        return waveHeight;
+
+    // 与 water.frag 相同的法线扰动，纹理坐标为 世界坐标 / POND_SIZE + 0.5
+    void bakeDetailLayer(int layer) {
+        const int n = DETAIL_SIZE;
+        float time = DETAIL_PERIOD * layer / DETAIL_LAYERS;
+        uint8_t* out = detailTexels.data() + static_cast<size_t>(layer) * n * n * 2;
+        for (int z = 0; z < n; z++) {
+            float v = (z + 0.5f) * TILE / n / POND_SIZE + 0.5f;
+            for (int x = 0; x < n; x++) {
+                float u = (x + 0.5f) * TILE / n / POND_SIZE + 0.5f;
+                float nx = std::sin(u * 40.0f + time * 4.0f) * std::sin(v * 30.0f + time * 3.0f) * 0.04f
+                         + std::sin(u * 80.0f + time * 8.0f) * std::sin(v * 70.0f + time * 7.0f) * 0.01f;
+                float nz = std::cos(u * 35.0f + time * 3.5f) * std::cos(v * 45.0f + time * 4.5f) * 0.04f
+                         + std::cos(u * 75.0f + time * 7.5f) * std::cos(v * 85.0f + time * 8.5f) * 0.01f;
+                uint8_t* texel = out + (static_cast<size_t>(z) * n + x) * 2;
+                texel[0] = encode(nx, DETAIL_RANGE);
+                texel[1] = encode(nz, DETAIL_RANGE);
+            }
+        }
+    }
+
+    static unsigned int createArray(GLint internalFormat, GLenum format, int size, int layers, const uint8_t* data, bool mipmaps) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, size, size, layers, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (mipmaps) glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return texture;
     }
 };
 
@@ -528,19 +2900,38 @@ public:
     std::unique_ptr<Shader> skyShader;    // New: sky shader
     std::unique_ptr<Shader> moonShader;   // New: moon shader
     std::unique_ptr<Shader> starShader;   // New: star shader
-    std::unique_ptr<Shader> trailShader;  // New: raindrop trail shader
+    std::unique_ptr<Shader> trailShader;  // New: raindrop trail shader (batched, screen-space quads)
     std::unique_ptr<Shader> lightningShader; // New: lightning shader
     
+    // 每帧设置多次的 uniform：着色器加载后解析一次（resolveUniformHandles）
+    UniformHandle<glm::vec3> raindropColorUniforms;
+    struct {
+        UniformHandle<glm::mat4> model;
+        UniformHandle<glm::vec3> color;
+        UniformHandle<float> size;
+        UniformHandle<float> brightness;
+    } starUniforms;
+    struct {
+        UniformHandle<glm::mat4> model;
+        UniformHandle<glm::vec3> color;
+        UniformHandle<float> intensity;
+    } lightningUniforms;
+    
     // Geometry
-    unsigned int waterVAO, waterVBO;
-    unsigned int raindropVAO, raindropVBO;
-    unsigned int rippleVAO, rippleVBO;
+    unsigned int waterVAO, waterEBO;        // 水面 clipmap（只有索引缓冲）
+    unsigned int raindropVAO, raindropVBO;  // 雨滴批量绘制（每帧流式更新的逐雨滴属性）
+    unsigned int pointVAO, pointVBO;        // 单个点精灵（星星）
+    unsigned int rippleVAO;
+    unsigned int rippleInstanceVBO;       // 涟漪实例属性（每帧流式更新，按细节层次分段）
+    RippleMesh rippleMesh;                // 各细节层次的环形网格
     unsigned int skyVAO, skyVBO;          // New: sky
     unsigned int moonVAO, moonVBO;        // New: moon
     unsigned int starVAO, starVBO;        // New: stars
     unsigned int trailVAO, trailVBO;      // New: raindrop trail
     unsigned int lightningVAO, lightningVBO; // New: lightning
-    unsigned int waterIndexCount;  // 水面索引数量
+    int clipmapFullCount = 0;      // 最内层完整网格的索引数
+    int clipmapRingOffset[4] = {}; // 各挖空位置的环在索引缓冲中的起点（索引个数）
+    int clipmapRingCount = 0;      // 每个环的索引数
     unsigned int skyVertexCount;   // 天空顶点数量
     
     // Textures
@@ -561,8 +2952,130 @@ public:
     bool keys[1024] = {false};
     
     // Raindrops and water ripples
-    std::vector<Raindrop> raindrops;
-    std::vector<WaterRipple> ripples;
+    RaindropPool raindrops;
+    RipplePool ripples;
+    
+    // 雨滴积分：运行时选定的SIMD实现
+    SimdLevel cpuSimdLevel;
+    RaindropKernel raindropKernel;
+    CullKernel cullKernel;
+    FftButterflyKernel fftKernel;
+    
+    // 生命周期调度：雨滴、涟漪和闪电生成时登记到期时刻，每步取出到期条目统一删除
+    TimingWheel timers;
+    std::vector<TimingWheel::Entry> firedTimers;
+    double simulationTime = 0.0;     // 已模拟的时间（步起点），调度器刻度由它换算
+    std::vector<int> raindropHits;   // 本步到期的雨滴下标（升序）
+    std::vector<int> raindropExpired;
+    IdTable lightningIds;
+    
+    // 并行更新（块划分固定，结果与线程数无关）
+    JobSystem jobs;
+    
+    // 涟漪中心的空间网格，下标与 ripples 池一致；每步删除后重建，生成时增量插入
+    SpatialGrid rippleGrid;
+    
+    // GPU雨滴模拟（可选后端）
+    GpuRaindropSystem gpuRaindrops;
+    
+    // 雨滴批量绘制的顶点数据（按距离排序后的逐雨滴属性）
+    struct RaindropVertex {
+        glm::vec4 positionLifetime;  // xyz 位置，w 存活时间
+        glm::vec4 attributes;        // x 大小，y 闪烁速度，z 颜色下标
+    };
+    std::vector<RaindropVertex> raindropVertices;
+    
+    // 涟漪实例数据：每个涟漪一条，属性除数为 3，三层共用同一条记录
+    struct RippleInstance {
+        glm::vec4 centerRadius;      // xyz 中心，w 插值后的半径
+        glm::vec4 colorOpacity;      // rgb 颜色，a 插值后的透明度
+        glm::vec4 wave;              // x 波浪高度，y 脉动频率
+    };
+    std::vector<RippleInstance> rippleInstances;
+    std::vector<int> rippleLods;                 // 每个可见涟漪选用的网格细节层次
+    
+    // 远处涟漪聚合：涟漪网格中离相机较远的格子不生成/不绘制单个涟漪，
+    // 撞击累加到格子的能量（随时间指数衰减），每个格子绘制一个程序化环纹四边形，开销与雨量无关
+    std::vector<float> aggregateEnergy;          // 按涟漪网格格子
+    std::vector<glm::vec3> aggregateColor;       // 能量加权的颜色和
+    std::vector<uint8_t> aggregateFar;           // 本帧格子是否在聚合距离之外
+    struct AggregateInstance {
+        glm::vec4 cell;                          // xy 格子中心 (x, z)，z 半边长，w 强度
+        glm::vec4 color;                         // rgb 平均颜色
+    };
+    std::vector<AggregateInstance> aggregateInstances;
+    std::vector<float> rippleFieldEnergy;        // 本帧的格子能量（含并入的远处单个涟漪）
+    std::vector<glm::vec3> rippleFieldColor;
+    unsigned int aggregateVAO = 0, aggregateVBO = 0;
+    std::unique_ptr<Shader> rippleFieldShader;
+    
+    // 解析涟漪着色：涟漪参数和水面分块列表写入纹理缓冲，water.frag 按所在块读取
+    // rippleData 每个涟漪两个纹素：(x, z, 半径, 脉动频率)、(颜色, 透明度)
+    // rippleTiles 每块一个 (起点, 数量)，指向 rippleTileIndices 中的涟漪编号
+    unsigned int rippleDataBuffer = 0, rippleDataTexture = 0;
+    unsigned int rippleTileBuffer = 0, rippleTileTexture = 0;
+    unsigned int rippleIndexBuffer = 0, rippleIndexTexture = 0;
+    std::vector<glm::vec4> rippleData;
+    std::vector<glm::ivec2> rippleTiles;
+    std::vector<int> rippleTileIndices;
+    std::vector<glm::ivec4> rippleTileBounds;  // 每个涟漪覆盖的块范围 (x0, z0, x1, z1)
+    std::vector<int> shadedRippleOrder;        // 可见涟漪按年龄选出的前 maxShadedRipples 个在最前
+    GpuTimer waterTimers[2];                   // 每种涟漪方式下水面绘制的GPU耗时
+    
+    // 拖尾批量绘制的顶点数据（GL_LINES，每条线段两个顶点）
+    struct TrailVertex {
+        glm::vec3 position;
+        float alpha;
+        glm::vec3 color;
+        float width;     // 屏幕空间宽度（像素）
+    };
+    std::vector<TrailVertex> trailVertices;
+    std::vector<std::pair<float, int>> sortedRaindrops;  // 排序模式下按距离排序的雨滴
+    
+    // 视锥剔除结果：可见对象的下标（升序），近层雨滴排在前 nearCount 个
+    // 主视图和平面反射各有一份，反射的剔除不会覆盖主视图的列表和统计
+    struct CullOutput {
+        std::vector<int> raindrops;  // 按雨滴池容量分配，前 raindropCount 个有效
+        int raindropCount = 0;
+        int nearCount = 0;
+        std::vector<int> ripples;
+        std::vector<int> stars;
+        int culledRaindrops = 0;
+        int culledRipples = 0;
+        int culledStars = 0;
+    };
+    CullOutput visible;
+    CullOutput reflectionVisible;
+    std::vector<float> cullX, cullY, cullZ, cullRadius; // 涟漪和星星的包围球（SoA）
+    
+    // 顺序无关透明度：不透明场景先画到 sceneFBO，透明物体累积到 oitFBO（共享深度缓冲）后合成
+    unsigned int sceneFBO = 0, sceneColorTexture = 0, sceneDepthRBO = 0;
+    unsigned int oitFBO = 0, oitAccumTexture = 0, oitRevealageTexture = 0;
+    int renderTargetWidth = 0, renderTargetHeight = 0;
+    unsigned int fullscreenVAO = 0;      // 全屏三角形（顶点由 gl_VertexID 生成）
+    std::unique_ptr<Shader> oitResolveShader;
+    bool oitActive = false;              // 正在进行OIT累积，渲染函数不修改混合状态
+    GpuTimer transparentTimers[2][2];    // 每种透明模式（第一维）和涟漪方式（第二维）下透明物体的GPU耗时
+    
+    // 平面反射：按水面镜像的相机把天空、月亮、星星、雨和闪电画到低分辨率目标，每隔几帧刷新一次
+    unsigned int reflectionFBO = 0, reflectionColorTexture = 0, reflectionDepthRBO = 0;
+    int reflectionWidth = 0, reflectionHeight = 0;
+    int reflectionAge = 0;                   // 距上次刷新经过的帧数
+    glm::mat4 reflectionViewProjection = glm::mat4(1.0f); // 上次刷新时的镜像视图投影，水面用它重投影
+    GpuTimer reflectionTimer;
+    
+    // 水面高度场：撞击写入波动方程网格，水面着色器采样位移和法线
+    WaveHeightfield heightfield;
+    GpuTimer heightfieldTimer;
+    
+    // FFT 海浪：CPU 上逐帧变换，结果（高度、x/z 斜率）上传到一张可平铺的纹理供水面采样
+    OceanFft ocean;
+    unsigned int oceanTexture = 0;
+    float oceanWindSpeed = 0.0f;         // 当前频谱对应的风速
+    float oceanUploadMs = 0.0f;
+    
+    // 叠加正弦波的预烘焙图集（FFT 海浪关闭时使用）
+    WaveAtlas waveAtlas;
     
     // New: stars and clouds
     std::vector<Star> stars;
@@ -573,11 +3086,23 @@ public:
     float lightningTimer;
     float nextLightningTime;
     
+    // 所有随机量都由同一个场景种子派生，相同种子可完全重现场景
+    uint64_t sceneSeed;
+    CounterRng spawnRng;
+    CounterRng rippleRng;
+    CounterRng lightningRng;
+    CounterRng audioRng;
+    CounterRng sceneryRng;
+    CounterRng textureRng;
+    
     // Configuration
     struct {
-        int rainDensity = 200;  // 增加雨滴密度
+        int rainDensity = 200;  // 增加雨滴密度（每秒生成 rainDensity * RAIN_DROPS_PER_DENSITY 个）
         float maxRippleSize = 60.0f; // 大幅增加最大涟漪大小
-        float updateInterval = 0.008f; // 更频繁的更新
+        int simulationRate = 60; // 固定模拟频率（Hz），与帧率无关
+        // 雨滴细节层次阈值（layerDepth）：超过 lodMidDepth 拖尾缩短，超过 lodFarDepth 只绘制点
+        float lodMidDepth = 0.35f;
+        float lodFarDepth = 0.7f;
         float rippleFadeSpeed = 0.015f;
         std::vector<glm::vec3> raindropColors = {
             glm::vec3(0.9f, 0.2f, 1.0f), // 更亮的紫色
@@ -616,6 +3141,45 @@ public:
         float rippleVisibility = 2.0f; // 涟漪可见度增强
         // Show debug info
         bool showDebugInfo = true;
+        // 透明物体混合方式（TransparencyMode）
+        int transparencyMode = TRANSPARENCY_SORTED;
+        // 雨滴积分指令集：0=自动，其余为 SimdLevel + 1
+        int integrationKernel = 0;
+        // 模拟更新的工作线程数（不含主线程）
+        int workerThreads = 0;
+        // GPU雨滴模拟
+        bool gpuRaindrops = false;
+        int gpuRaindropCount = 1 << 18;
+        int gpuMaxImpactsPerFrame = 64; // 每帧由撞击生成的涟漪/声音上限
+        int maxRipplesPerCell = 16;     // 每个网格格子中同时存在的涟漪上限
+        float rippleMergeRadius = 3.0f; // 撞击并入附近新涟漪的距离（0 关闭）
+        // 涟漪绘制方式（RippleShadingMode）及解析着色时每帧写入的涟漪上限
+        int rippleShading = RIPPLE_SHADING_GEOMETRY;
+        int maxShadedRipples = 512;
+        // 提交绘制前在CPU上做视锥剔除
+        bool frustumCulling = true;
+        // 平面反射：分辨率比例和刷新间隔（帧）
+        bool planarReflection = true;
+        float reflectionScale = 0.5f;
+        int reflectionInterval = 2;
+        // 远处涟漪聚合为每格一个强度场
+        bool rippleAggregation = true;
+        float rippleAggregateDistance = 200.0f;
+        // 水面高度场（GPU波动方程）
+        bool waveHeightfield = true;
+        int heightfieldResolution = 256;    // 网格每边的纹素数
+        float heightfieldWaveSpeed = 20.0f; // 波速（世界单位/秒）
+        float heightfieldDamping = 0.8f;    // 每秒衰减率
+        float heightfieldImpulse = 0.3f;    // 单次撞击的下压深度
+        float heightfieldScale = 1.0f;      // 水面位移和法线的缩放
+        // FFT 海浪（替代叠加正弦波）
+        bool oceanFft = true;
+        int oceanResolution = 128;          // 频域网格每边的样本数（2 的幂）
+        float oceanPatchSize = 120.0f;      // 平铺波块的边长（世界单位）
+        float oceanWindSpeed = 12.0f;       // 风速决定谱中最长的波
+        float oceanAmplitude = 0.6f;        // 高度均方根（再乘波浪强度）
+        // 叠加正弦波改为采样预烘焙的图集（FFT 海浪关闭时）
+        bool bakedWaves = true;
     } config;
     
     // SDL audio related members
@@ -635,8 +3199,13 @@ public:
     
     // 时间追踪
     float lastFrame = 0.0f;
-    float deltaTime = 0.0f;
-    float rainAccumulator = 0.0f;
+    float frameDeltaTime = 0.0f;     // 实际帧间隔（输入和统计用）
+    float deltaTime = 0.0f;          // 模拟步长，固定为 1 / config.simulationRate
+    float simAccumulator = 0.0f;     // 尚未模拟的剩余时间
+    float interpolationAlpha = 1.0f; // 渲染位置在上一步与当前步之间的比例
+    float emissionAccumulator = 0.0f; // 尚未生成的雨滴（小数部分留到下一步）
+    int farPhase = 0;                // 距上次远层积分经过的步数
+    int lodCounts[LOD_TIER_COUNT] = { 0, 0, 0 };
     float totalTime = 0.0f; // 总运行时间
     
     // 手动闪电触发
@@ -649,9 +3218,38 @@ public:
         float frameTimeMs = 0.0f;
         uint32_t totalFrames = 0;
         float fpsUpdateTime = 0.0f;
+        float raindropUpdateMs = 0.0f; // 雨滴积分耗时（平滑）
+        float simStepsPerFrame = 0.0f; // 每帧平均模拟步数
+        float nearUpdateMs = 0.0f;     // 近/中层积分耗时（含拖尾）
+        float farUpdateMs = 0.0f;      // 远层积分耗时（只在远层步统计）
+        int trailSegments = 0;         // 上一帧绘制的拖尾线段数
+        float transparentCpuMs[2] = { 0.0f, 0.0f }; // 每种透明模式的CPU耗时（排序、上传、提交）
+        float cullMs = 0.0f;           // 视锥剔除耗时
+        float sceneCpuMs[2] = { 0.0f, 0.0f }; // 关闭/开启剔除时场景绘制的CPU耗时（含剔除）
+        int culledRaindrops = 0;
+        int culledRipples = 0;
+        int culledStars = 0;
+        int ripplesCapped = 0;         // 上一步因格子已满而未生成的涟漪数
+        int ripplesMerged = 0;         // 上一步并入附近新涟漪的撞击数
+        int timersFired = 0;           // 上一步到期的调度条目数
+        int heightfieldImpulses = 0;   // 上一步写入高度场的撞击数
+        float rippleCpuMs[2] = { 0.0f, 0.0f }; // 每种涟漪方式的CPU耗时（实例/分块构建、上传、提交）
+        int shadedRipples = 0;         // 上一帧解析着色的涟漪数
+        int ripplesOverCap = 0;        // 上一帧超出上限未着色的可见涟漪数
+        int rippleTileEntries = 0;     // 上一帧分块列表的总条目数
+        int rippleLodCounts[RippleMesh::LOD_COUNT] = {}; // 上一帧各网格层次的涟漪数
+        int rippleVertices = 0;        // 上一帧涟漪绘制的顶点数（三层合计）
+        int aggregatedImpacts = 0;     // 上一步写入聚合场的撞击数
+        int waterTriangles = 0;        // 上一帧水面 clipmap 绘制的三角形数
+        int aggregatedRipples = 0;     // 上一帧并入聚合场的远处单个涟漪数
+        int aggregateCells = 0;        // 上一帧绘制的聚合格子数
+        float reflectionCpuMs = 0.0f;  // 反射刷新的CPU耗时（含剔除，只在刷新帧统计）
+        int reflectionUpdates = 0;     // 累计刷新次数
+        int uniformUploads = 0;        // 上一帧的 glUniform* 调用数
+        int uniformsSkipped = 0;       // 上一帧因值未变而跳过的上传数
     } performanceMetrics;
     
-    RainSimulation() : 
+    explicit RainSimulation(uint64_t seed) : 
     window(nullptr),
     cameraPos(glm::vec3(0.0f, 60.0f, 120.0f)), // 进一步提高高度和距离以获得更好的全景视角
     cameraFront(glm::vec3(0.0f, -0.45f, -1.0f)), // 更大角度向下看以覆盖更大的池塘区域
@@ -662,7 +3260,15 @@ public:
     ambientRainSound(nullptr),
     waterRippleSound(nullptr),
     lightningTimer(0.0f),
-    nextLightningTime(2.0f) { // 缩短初始等待时间
+    nextLightningTime(2.0f), // 缩短初始等待时间
+    sceneSeed(seed),
+    spawnRng(seed, RNG_STREAM_SPAWN),
+    rippleRng(seed, RNG_STREAM_RIPPLE),
+    lightningRng(seed, RNG_STREAM_LIGHTNING),
+    audioRng(seed, RNG_STREAM_AUDIO),
+    sceneryRng(seed, RNG_STREAM_SCENERY),
+    textureRng(seed, RNG_STREAM_TEXTURE) {
+        gpuRaindrops.seedKey = CounterRng(seed, RNG_STREAM_GPU).nextU32();
     }
     
     ~RainSimulation() {
@@ -670,12 +3276,40 @@ public:
         cleanup();
 
         // Release resources
+        gpuRaindrops.release();
+        heightfield.release();
+        heightfieldTimer.release();
+        glDeleteTextures(1, &oceanTexture);
+        waveAtlas.release();
+        releaseReflectionTarget();
+        reflectionTimer.release();
+        for (auto& timer : waterTimers) {
+            timer.release();
+        }
+        glDeleteTextures(1, &rippleDataTexture);
+        glDeleteTextures(1, &rippleTileTexture);
+        glDeleteTextures(1, &rippleIndexTexture);
+        glDeleteBuffers(1, &rippleDataBuffer);
+        glDeleteBuffers(1, &rippleTileBuffer);
+        glDeleteBuffers(1, &rippleIndexBuffer);
+        releaseRenderTargets();
+        glDeleteVertexArrays(1, &fullscreenVAO);
+        for (auto& timers : transparentTimers) {
+            for (auto& timer : timers) {
+                timer.release();
+            }
+        }
         glDeleteVertexArrays(1, &waterVAO);
-        glDeleteBuffers(1, &waterVBO);
+        glDeleteBuffers(1, &waterEBO);
         glDeleteVertexArrays(1, &raindropVAO);
         glDeleteBuffers(1, &raindropVBO);
+        glDeleteVertexArrays(1, &pointVAO);
+        glDeleteBuffers(1, &pointVBO);
         glDeleteVertexArrays(1, &rippleVAO);
-        glDeleteBuffers(1, &rippleVBO);
+        rippleMesh.release();
+        glDeleteVertexArrays(1, &aggregateVAO);
+        glDeleteBuffers(1, &aggregateVBO);
+        glDeleteBuffers(1, &rippleInstanceVBO);
         glDeleteVertexArrays(1, &skyVAO);
         glDeleteBuffers(1, &skyVBO);
         glDeleteVertexArrays(1, &moonVAO);
@@ -813,7 +3447,7 @@ public:
         float volumeScale = 1.0f - std::min(distance / 50.0f, 0.95f); // 50.0f is maximum audible distance
         
         // Randomize volume and pitch for variety
-        float volumeVariation = 0.8f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
+        float volumeVariation = 0.8f + audioRng.uniform() * 0.4f;
         int volume = static_cast<int>(audioConfig.raindropVolume * MIX_MAX_VOLUME * volumeScale * volumeVariation);
         
         // Find an available channel to play
@@ -825,6 +3459,7 @@ public:
     }
 
     // Function to play water ripple sound
+    // 在撞击点播放，不依赖涟漪是否生成（格子已满或并入附近涟漪时同样发声）
     void playRippleSound(const glm::vec3& position) {
         if (!audioConfig.soundEnabled || !waterRippleSound)
             return;
@@ -834,7 +3469,7 @@ public:
         float volumeScale = 1.0f - std::min(distance / 50.0f, 0.95f); // 50.0f is maximum audible distance
         
         // Randomize volume for variety
-        float volumeVariation = 0.7f + static_cast<float>(rand()) / RAND_MAX * 0.6f;
+        float volumeVariation = 0.7f + audioRng.uniform() * 0.6f;
         int volume = static_cast<int>(audioConfig.rippleVolume * MIX_MAX_VOLUME * volumeScale * volumeVariation * 0.5f);
         
         // Find an available channel to play
@@ -947,6 +3582,7 @@ public:
         
         // Load shaders
         loadShaders();
+        resolveUniformHandles();
         
         // Create geometry
         createGeometry();
@@ -954,6 +3590,28 @@ public:
         // Load textures
         loadTextures();
         
+        // 预分配雨滴池
+        raindrops.init(RAINDROP_POOL_CAPACITY);
+        raindropHits.reserve(RAINDROP_POOL_CAPACITY);
+        raindropExpired.reserve(RAINDROP_POOL_CAPACITY);
+        ripples.init(RIPPLE_POOL_CAPACITY);
+        rippleGrid.init(POND_SIZE, RIPPLE_GRID_RESOLUTION);
+        aggregateEnergy.assign(RIPPLE_GRID_RESOLUTION * RIPPLE_GRID_RESOLUTION, 0.0f);
+        aggregateColor.assign(aggregateEnergy.size(), glm::vec3(0.0f));
+        aggregateFar.assign(aggregateEnergy.size(), 0);
+        cpuSimdLevel = detectSimdLevel();
+        raindropKernel = selectRaindropKernel(cpuSimdLevel);
+        cullKernel = selectCullKernel(cpuSimdLevel);
+        fftKernel = selectFftButterflyKernel(cpuSimdLevel);
+        visible.raindrops.resize(RAINDROP_POOL_CAPACITY);
+        reflectionVisible.raindrops.resize(RAINDROP_POOL_CAPACITY);
+        std::cout << "Raindrop integration kernel: " << simdLevelName(cpuSimdLevel) << std::endl;
+        
+        // 主线程之外的每个硬件线程启动一个工作线程
+        config.workerThreads = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        jobs.start(config.workerThreads);
+        std::cout << "Simulation threads: " << jobs.threadCount() << std::endl;
+        
         // Initialize stars
         initStars();
         
@@ -971,18 +3629,18 @@ public:
             Star star;
             
             // Random position - in sky dome
-            float theta = static_cast<float>(rand()) / RAND_MAX * 2.0f * glm::pi<float>();
-            float phi = static_cast<float>(rand()) / RAND_MAX * glm::pi<float>() * 0.5f; // Upper hemisphere
+            float theta = sceneryRng.uniform() * 2.0f * glm::pi<float>();
+            float phi = sceneryRng.uniform() * glm::pi<float>() * 0.5f; // Upper hemisphere
             
-            float radius = 200.0f + static_cast<float>(rand()) / RAND_MAX * 50.0f;
+            float radius = 200.0f + sceneryRng.uniform() * 50.0f;
             star.position.x = radius * sin(phi) * cos(theta);
             star.position.y = radius * cos(phi) + 20.0f; // Offset upward
             star.position.z = radius * sin(phi) * sin(theta);
             
             // Random brightness and twinkle speed
-            star.brightness = 0.5f + static_cast<float>(rand()) / RAND_MAX * 0.5f;
-            star.twinkleSpeed = 0.5f + static_cast<float>(rand()) / RAND_MAX * 5.0f;
-            star.size = 0.5f + static_cast<float>(rand()) / RAND_MAX * 1.5f;
+            star.brightness = 0.5f + sceneryRng.uniform() * 0.5f;
+            star.twinkleSpeed = 0.5f + sceneryRng.uniform() * 5.0f;
+            star.size = 0.5f + sceneryRng.uniform() * 1.5f;
             
             stars.push_back(star);
         }
@@ -996,25 +3654,40 @@ public:
             Cloud cloud;
             
             // Random position - in sky
-            cloud.position.x = -100.0f + static_cast<float>(rand()) / RAND_MAX * 200.0f;
-            cloud.position.y = 40.0f + static_cast<float>(rand()) / RAND_MAX * 30.0f;
-            cloud.position.z = -100.0f + static_cast<float>(rand()) / RAND_MAX * 100.0f;
+            cloud.position.x = -100.0f + sceneryRng.uniform() * 200.0f;
+            cloud.position.y = 40.0f + sceneryRng.uniform() * 30.0f;
+            cloud.position.z = -100.0f + sceneryRng.uniform() * 100.0f;
             
             // Random size, opacity and speed
-            cloud.size = 10.0f + static_cast<float>(rand()) / RAND_MAX * 20.0f;
-            cloud.opacity = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.3f;
-            cloud.speed = 0.5f + static_cast<float>(rand()) / RAND_MAX * 2.0f;
+            cloud.size = 10.0f + sceneryRng.uniform() * 20.0f;
+            cloud.opacity = 0.2f + sceneryRng.uniform() * 0.3f;
+            cloud.speed = 0.5f + sceneryRng.uniform() * 2.0f;
             
             clouds.push_back(cloud);
         }
     }
     
+    void resolveUniformHandles() {
+        raindropColorUniforms = raindropShader->uniform<glm::vec3>("raindropColors");
+        starUniforms.model = starShader->uniform<glm::mat4>("model");
+        starUniforms.color = starShader->uniform<glm::vec3>("raindropColor");
+        starUniforms.size = starShader->uniform<float>("raindropSize");
+        starUniforms.brightness = starShader->uniform<float>("brightness");
+        lightningUniforms.model = lightningShader->uniform<glm::mat4>("model");
+        lightningUniforms.color = lightningShader->uniform<glm::vec3>("lightningColor");
+        lightningUniforms.intensity = lightningShader->uniform<float>("intensity");
+    }
+    
     void loadShaders() {
         // Try both paths to find shader files
         const char* waterVertPath = "shaders/water.vert";
         const char* waterFragPath = "shaders/water.frag";
         const char* raindropVertPath = "shaders/raindrop.vert";
         const char* raindropFragPath = "shaders/raindrop.frag";
+        const char* spriteVertPath = "shaders/sprite.vert";
+        const char* trailVertPath = "shaders/trail.vert";
+        const char* trailGeomPath = "shaders/trail.geom";
+        const char* trailFragPath = "shaders/trail.frag";
         const char* rippleVertPath = "shaders/ripple.vert";
         const char* rippleFragPath = "shaders/ripple.frag";
         
@@ -1028,6 +3701,10 @@ public:
                 waterFragPath = "../shaders/water.frag";
                 raindropVertPath = "../shaders/raindrop.vert";
                 raindropFragPath = "../shaders/raindrop.frag";
+                spriteVertPath = "../shaders/sprite.vert";
+                trailVertPath = "../shaders/trail.vert";
+                trailGeomPath = "../shaders/trail.geom";
+                trailFragPath = "../shaders/trail.frag";
                 rippleVertPath = "../shaders/ripple.vert";
                 rippleFragPath = "../shaders/ripple.frag";
                 
@@ -1051,10 +3728,12 @@ public:
             rippleShader = std::make_unique<Shader>(rippleVertPath, rippleFragPath);
             
             // Reuse shaders for other elements
-            moonShader = std::make_unique<Shader>(raindropVertPath, raindropFragPath);
-            starShader = std::make_unique<Shader>(raindropVertPath, raindropFragPath);
-            trailShader = std::make_unique<Shader>(rippleVertPath, rippleFragPath);
+            moonShader = std::make_unique<Shader>(spriteVertPath, raindropFragPath);
+            starShader = std::make_unique<Shader>(spriteVertPath, raindropFragPath);
+            trailShader = std::make_unique<Shader>(trailVertPath, trailGeomPath, trailFragPath, std::vector<const char*>());
             lightningShader = std::make_unique<Shader>("shaders/lightning.vert", "shaders/lightning.frag");
+            oitResolveShader = std::make_unique<Shader>("shaders/oit_resolve.vert", "shaders/oit_resolve.frag");
+            rippleFieldShader = std::make_unique<Shader>("shaders/ripple_field.vert", "shaders/ripple_field.frag");
         }
         catch (const std::exception& e) {
             std::cerr << "Error loading shaders: " << e.what() << std::endl;
@@ -1067,157 +3746,137 @@ public:
             raindropShader = std::make_unique<Shader>("shaders/raindrop.vert", "shaders/raindrop.frag");
             rippleShader = std::make_unique<Shader>("shaders/ripple.vert", "shaders/ripple.frag");
             skyShader = std::make_unique<Shader>("shaders/water.vert", "shaders/water.frag");
-            moonShader = std::make_unique<Shader>("shaders/raindrop.vert", "shaders/raindrop.frag");
-            starShader = std::make_unique<Shader>("shaders/raindrop.vert", "shaders/raindrop.frag");
-            trailShader = std::make_unique<Shader>("shaders/ripple.vert", "shaders/ripple.frag");
+            moonShader = std::make_unique<Shader>("shaders/sprite.vert", "shaders/raindrop.frag");
+            starShader = std::make_unique<Shader>("shaders/sprite.vert", "shaders/raindrop.frag");
+            trailShader = std::make_unique<Shader>("shaders/trail.vert", "shaders/trail.geom", "shaders/trail.frag", std::vector<const char*>());
             lightningShader = std::make_unique<Shader>("shaders/lightning.vert", "shaders/lightning.frag");
+            oitResolveShader = std::make_unique<Shader>("shaders/oit_resolve.vert", "shaders/oit_resolve.frag");
+            rippleFieldShader = std::make_unique<Shader>("shaders/ripple_field.vert", "shaders/ripple_field.frag");
         }
     }
     
     void createGeometry() {
-        // 创建水面平面 - 使用更多顶点以支持更大的水面和更好的波浪效果
-        std::vector<float> waterVertices;
-        const int gridSize = 64;  // 大幅增加网格密度以减少锯齿
-        const float cellSize = POND_SIZE / gridSize;
-        
-        for (int z = 0; z <= gridSize; z++) {
-            for (int x = 0; x <= gridSize; x++) {
-                float xPos = -POND_SIZE/2 + x * cellSize;
-                float zPos = -POND_SIZE/2 + z * cellSize;
-                float texU = (float)x / gridSize;
-                float texV = (float)z / gridSize;
-                
-                waterVertices.push_back(xPos);
-                waterVertices.push_back(0.0f);
-                waterVertices.push_back(zPos);
-                waterVertices.push_back(texU);
-                waterVertices.push_back(texV);
-            }
-        }
-        
+        // 水面 clipmap：所有层共用 (CLIPMAP_GRID + 1)² 个顶点的网格，顶点位置在 water.vert 中由 gl_VertexID 生成
+        // 索引缓冲依次存放完整网格（最内层）和四种挖空位置的环（内层中心相对本层偏移 0 或 1 格）
+        const int grid = CLIPMAP_GRID;
         std::vector<unsigned int> waterIndices;
-        for (int z = 0; z < gridSize; z++) {
-            for (int x = 0; x < gridSize; x++) {
-                unsigned int topLeft = z * (gridSize + 1) + x;
-                unsigned int topRight = topLeft + 1;
-                unsigned int bottomLeft = (z + 1) * (gridSize + 1) + x;
-                unsigned int bottomRight = bottomLeft + 1;
-                
-                // 第一个三角形
-                waterIndices.push_back(topLeft);
-                waterIndices.push_back(bottomLeft);
-                waterIndices.push_back(topRight);
-                
-                // 第二个三角形
-                waterIndices.push_back(topRight);
-                waterIndices.push_back(bottomLeft);
-                waterIndices.push_back(bottomRight);
+        auto addQuads = [&](int holeX, int holeZ, bool ring) {
+            for (int z = 0; z < grid; z++) {
+                for (int x = 0; x < grid; x++) {
+                    bool inHole = x >= grid / 4 + holeX && x < grid * 3 / 4 + holeX &&
+                                  z >= grid / 4 + holeZ && z < grid * 3 / 4 + holeZ;
+                    if (ring && inHole) continue;
+                    
+                    unsigned int topLeft = z * (grid + 1) + x;
+                    unsigned int topRight = topLeft + 1;
+                    unsigned int bottomLeft = (z + 1) * (grid + 1) + x;
+                    unsigned int bottomRight = bottomLeft + 1;
+                    
+                    // 第一个三角形
+                    waterIndices.push_back(topLeft);
+                    waterIndices.push_back(bottomLeft);
+                    waterIndices.push_back(topRight);
+                    
+                    // 第二个三角形
+                    waterIndices.push_back(topRight);
+                    waterIndices.push_back(bottomLeft);
+                    waterIndices.push_back(bottomRight);
+                }
             }
+        };
+        addQuads(0, 0, false);
+        clipmapFullCount = static_cast<int>(waterIndices.size());
+        for (int hole = 0; hole < 4; hole++) {
+            clipmapRingOffset[hole] = static_cast<int>(waterIndices.size());
+            addQuads(hole & 1, hole >> 1, true);
         }
+        clipmapRingCount = static_cast<int>(waterIndices.size()) - clipmapRingOffset[3];
         
-        unsigned int waterEBO;
+        // 核心模式下仍需绑定VAO；索引缓冲记录在VAO中，没有顶点属性
         glGenVertexArrays(1, &waterVAO);
-        glGenBuffers(1, &waterVBO);
         glGenBuffers(1, &waterEBO);
-        
         glBindVertexArray(waterVAO);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, waterVBO);
-        glBufferData(GL_ARRAY_BUFFER, waterVertices.size() * sizeof(float), waterVertices.data(), GL_STATIC_DRAW);
-        
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, waterEBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, waterIndices.size() * sizeof(unsigned int), waterIndices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
         
-        // 位置属性
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        
-        // 纹理坐标属性
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        
-        // 保存索引数量供渲染时使用
-        waterIndexCount = waterIndices.size();
-        
-        // 创建雨滴点
-        float raindropVertices[] = {
+        // 创建单个点精灵（星星）
+        float pointVertices[] = {
             // 一个点
             0.0f, 0.0f, 0.0f
         };
         
+        glGenVertexArrays(1, &pointVAO);
+        glGenBuffers(1, &pointVBO);
+        
+        glBindVertexArray(pointVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, pointVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(pointVertices), pointVertices, GL_STATIC_DRAW);
+        
+        // 位置属性
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        
+        // 创建雨滴批量缓冲：每个雨滴一个点，属性每帧整体流式上传
         glGenVertexArrays(1, &raindropVAO);
         glGenBuffers(1, &raindropVBO);
         
         glBindVertexArray(raindropVAO);
         glBindBuffer(GL_ARRAY_BUFFER, raindropVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(raindropVertices), raindropVertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, RAINDROP_POOL_CAPACITY * sizeof(RaindropVertex), nullptr, GL_STREAM_DRAW);
         
-        // 位置属性
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        // 位置 + 存活时间
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(RaindropVertex), (void*)offsetof(RaindropVertex, positionLifetime));
         glEnableVertexAttribArray(0);
         
+        // 大小、闪烁速度、颜色下标
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(RaindropVertex), (void*)offsetof(RaindropVertex, attributes));
+        glEnableVertexAttribArray(1);
+        
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
         
-        // 创建水波环 - 更多节点和细节
-        std::vector<float> rippleVertices;
-        const int segments = 256; // 大幅增加细节以减少锯齿
-        
-        // 创建多个同心环
-        for (int ring = 0; ring < config.rippleRings; ring++) {
-            float innerRadius = 0.7f + 0.1f * ring;
-            float outerRadius = 0.9f + 0.1f * ring;
-            
-            for (int i = 0; i < segments; ++i) {
-                float theta1 = 2.0f * glm::pi<float>() * float(i) / float(segments);
-                float theta2 = 2.0f * glm::pi<float>() * float(i + 1) / float(segments);
-                
-                // 内环点
-                rippleVertices.push_back(innerRadius * cos(theta1));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(innerRadius * sin(theta1));
-                
-                // 外环点
-                rippleVertices.push_back(outerRadius * cos(theta1));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(outerRadius * sin(theta1));
-                
-                // 外环点 (下一个)
-                rippleVertices.push_back(outerRadius * cos(theta2));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(outerRadius * sin(theta2));
-                
-                // 内环点
-                rippleVertices.push_back(innerRadius * cos(theta1));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(innerRadius * sin(theta1));
-                
-                // 外环点 (下一个)
-                rippleVertices.push_back(outerRadius * cos(theta2));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(outerRadius * sin(theta2));
-                
-                // 内环点 (下一个)
-                rippleVertices.push_back(innerRadius * cos(theta2));
-                rippleVertices.push_back(0.0f);
-                rippleVertices.push_back(innerRadius * sin(theta2));
-            }
-        }
+        raindropVertices.reserve(RAINDROP_POOL_CAPACITY);
         
+        // 创建水波环：几种分段数的索引三角带，绘制时按屏幕大小选用，环数改变时重新生成
         glGenVertexArrays(1, &rippleVAO);
-        glGenBuffers(1, &rippleVBO);
+        glGenBuffers(1, &rippleInstanceVBO);
         
         glBindVertexArray(rippleVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, rippleVBO);
-        glBufferData(GL_ARRAY_BUFFER, rippleVertices.size() * sizeof(float), rippleVertices.data(), GL_STATIC_DRAW);
+        rippleMesh.attach(config.rippleRings);
         
-        // 位置属性
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+        // 实例属性：每 3 个实例（三层）前进一条记录，层号由 gl_InstanceID % 3 得到
+        glBindBuffer(GL_ARRAY_BUFFER, rippleInstanceVBO);
+        bindRippleInstances(0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 3);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 3);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 3);
+        
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
         
+        // 远处涟漪聚合场：每个格子一个实例，四边形的四个角由 gl_VertexID 生成
+        glGenVertexArrays(1, &aggregateVAO);
+        glGenBuffers(1, &aggregateVBO);
+        glBindVertexArray(aggregateVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, aggregateVBO);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(AggregateInstance), (void*)offsetof(AggregateInstance, cell));
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, 1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(AggregateInstance), (void*)offsetof(AggregateInstance, color));
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
         
+        // 解析涟漪着色用的纹理缓冲（数据每帧重新上传）
+        createTextureBuffer(rippleDataBuffer, rippleDataTexture, GL_RGBA32F);
+        createTextureBuffer(rippleTileBuffer, rippleTileTexture, GL_RG32I);
+        createTextureBuffer(rippleIndexBuffer, rippleIndexTexture, GL_R32I);
+        
         // 创建天空穹顶 - 使用更大的半径以避免裁剪
         std::vector<float> skyVertices;
         const int skySegments = 32;
@@ -1311,24 +3970,24 @@ public:
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
         
-        // 创建雨滴轨迹几何体
-        float trailVertices[] = {
-            -0.5f, 0.0f, 0.0f,
-             0.5f, 0.0f, 0.0f,
-             0.0f, 2.0f, 0.0f
-        };
+        // OIT合成用的全屏三角形不需要顶点属性，但核心模式要求绑定VAO
+        glGenVertexArrays(1, &fullscreenVAO);
         
+        // 创建雨滴拖尾批量缓冲（内容每帧流式上传）
         glGenVertexArrays(1, &trailVAO);
         glGenBuffers(1, &trailVBO);
         
         glBindVertexArray(trailVAO);
         glBindBuffer(GL_ARRAY_BUFFER, trailVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(trailVertices), trailVertices, GL_STATIC_DRAW);
         
-        // 位置属性
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        // 位置 + 透明度
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TrailVertex), (void*)offsetof(TrailVertex, position));
         glEnableVertexAttribArray(0);
         
+        // 颜色 + 宽度
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TrailVertex), (void*)offsetof(TrailVertex, color));
+        glEnableVertexAttribArray(1);
+        
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
         
@@ -1428,9 +4087,9 @@ public:
                 // Default value for normal map: random normals
                 for (int i = 0; i < 8*8; i++) {
                     // Random normal - mapped to RGB values
-                    float nx = (static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f) * 0.2f;
-                    float ny = 0.8f + static_cast<float>(rand()) / RAND_MAX * 0.2f;
-                    float nz = (static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f) * 0.2f;
+                    float nx = (textureRng.uniform() * 2.0f - 1.0f) * 0.2f;
+                    float ny = 0.8f + textureRng.uniform() * 0.2f;
+                    float nz = (textureRng.uniform() * 2.0f - 1.0f) * 0.2f;
                     
                     float length = sqrt(nx*nx + ny*ny + nz*nz);
                     nx /= length;
@@ -1448,8 +4107,8 @@ public:
                 // Default value for DuDv map: random distortions
                 for (int i = 0; i < 8*8; i++) {
                     // Random distortion values
-                    defaultTextureData[i*4+0] = 128 + rand() % 40 - 20; // R
-                    defaultTextureData[i*4+1] = 128 + rand() % 40 - 20; // G
+                    defaultTextureData[i*4+0] = 128 + textureRng.nextInt(40) - 20; // R
+                    defaultTextureData[i*4+1] = 128 + textureRng.nextInt(40) - 20; // G
                     defaultTextureData[i*4+2] = 128; // B
                     defaultTextureData[i*4+3] = 255; // A
                 }
@@ -1461,15 +4120,15 @@ public:
                         int i = y*8 + x;
                         
                         // Base deep blue tone
-                        defaultTextureData[i*4+0] = 10 + rand() % 20;  // R
-                        defaultTextureData[i*4+1] = 20 + rand() % 30;  // G
-                        defaultTextureData[i*4+2] = 40 + rand() % 50;  // B
+                        defaultTextureData[i*4+0] = 10 + textureRng.nextInt(20);  // R
+                        defaultTextureData[i*4+1] = 20 + textureRng.nextInt(30);  // G
+                        defaultTextureData[i*4+2] = 40 + textureRng.nextInt(50);  // B
                         
                         // Occasionally add star reflections
-                        if (rand() % 20 == 0) {
-                            defaultTextureData[i*4+0] = 200 + rand() % 55; // R
-                            defaultTextureData[i*4+1] = 200 + rand() % 55; // G
-                            defaultTextureData[i*4+2] = 200 + rand() % 55; // B
+                        if (textureRng.nextInt(20) == 0) {
+                            defaultTextureData[i*4+0] = 200 + textureRng.nextInt(55); // R
+                            defaultTextureData[i*4+1] = 200 + textureRng.nextInt(55); // G
+                            defaultTextureData[i*4+2] = 200 + textureRng.nextInt(55); // B
                         }
                         
                         defaultTextureData[i*4+3] = 255; // A
@@ -1513,10 +4172,10 @@ public:
                         defaultTextureData[i*4+2] = static_cast<unsigned char>(30 + (1.0f - gradient) * 50); // B
                         
                         // Randomly add stars
-                        if (rand() % 30 == 0) {
-                            defaultTextureData[i*4+0] = 200 + rand() % 55; // R
-                            defaultTextureData[i*4+1] = 200 + rand() % 55; // G
-                            defaultTextureData[i*4+2] = 200 + rand() % 55; // B
+                        if (textureRng.nextInt(30) == 0) {
+                            defaultTextureData[i*4+0] = 200 + textureRng.nextInt(55); // R
+                            defaultTextureData[i*4+1] = 200 + textureRng.nextInt(55); // G
+                            defaultTextureData[i*4+2] = 200 + textureRng.nextInt(55); // B
                         }
                         
                         defaultTextureData[i*4+3] = 255; // A
@@ -1616,27 +4275,27 @@ public:
                 
                 if (path.find("normal") != std::string::npos) {
                     // Normal map: random bumps
-                    data[i+0] = 128 + (rand() % 40 - 20); // R
-                    data[i+1] = 128 + (rand() % 40 - 20); // G
-                    data[i+2] = 200 + (rand() % 55); // B - mainly upward
+                    data[i+0] = 128 + (textureRng.nextInt(40) - 20); // R
+                    data[i+1] = 128 + (textureRng.nextInt(40) - 20); // G
+                    data[i+2] = 200 + (textureRng.nextInt(55)); // B - mainly upward
                     data[i+3] = 255; // A
                 } else if (path.find("DuDv") != std::string::npos) {
                     // DuDv map: random distortions
-                    data[i+0] = 128 + (rand() % 30 - 15); // R
-                    data[i+1] = 128 + (rand() % 30 - 15); // G
+                    data[i+0] = 128 + (textureRng.nextInt(30) - 15); // R
+                    data[i+1] = 128 + (textureRng.nextInt(30) - 15); // G
                     data[i+2] = 128; // B
                     data[i+3] = 255; // A
                 } else if (path.find("Reflection") != std::string::npos) {
                     // Reflection map: night sky star effect
-                    data[i+0] = 10 + (rand() % 20); // R
-                    data[i+1] = 20 + (rand() % 30); // G
-                    data[i+2] = 50 + (rand() % 40); // B
+                    data[i+0] = 10 + (textureRng.nextInt(20)); // R
+                    data[i+1] = 20 + (textureRng.nextInt(30)); // G
+                    data[i+2] = 50 + (textureRng.nextInt(40)); // B
                     
                     // Random sprinkle of stars
-                    if (rand() % 20 == 0) {
-                        data[i+0] = 200 + (rand() % 55); // R
-                        data[i+1] = 200 + (rand() % 55); // G
-                        data[i+2] = 200 + (rand() % 55); // B
+                    if (textureRng.nextInt(20) == 0) {
+                        data[i+0] = 200 + (textureRng.nextInt(55)); // R
+                        data[i+1] = 200 + (textureRng.nextInt(55)); // G
+                        data[i+2] = 200 + (textureRng.nextInt(55)); // B
                     }
                     data[i+3] = 255; // A
                 } else if (path.find("glow") != std::string::npos) {
@@ -1660,10 +4319,10 @@ public:
                     data[i+2] = static_cast<unsigned char>(30 + (1.0f - gradient) * 70); // B
                     
                     // Random stars
-                    if (rand() % 20 == 0) {
-                        data[i+0] = 200 + (rand() % 55); // R
-                        data[i+1] = 200 + (rand() % 55); // G
-                        data[i+2] = 200 + (rand() % 55); // B
+                    if (textureRng.nextInt(20) == 0) {
+                        data[i+0] = 200 + (textureRng.nextInt(55)); // R
+                        data[i+1] = 200 + (textureRng.nextInt(55)); // G
+                        data[i+2] = 200 + (textureRng.nextInt(55)); // B
                     }
                     
                     data[i+3] = 255; // A
@@ -1758,14 +4417,14 @@ public:
         while (!glfwWindowShouldClose(window)) {
             // Handle time
             float currentFrame = glfwGetTime();
-            deltaTime = currentFrame - lastFrame;
+            frameDeltaTime = currentFrame - lastFrame;
             lastFrame = currentFrame;
-            totalTime += deltaTime;
+            totalTime += frameDeltaTime;
             
             // Update performance metrics
             performanceMetrics.totalFrames++;
-            performanceMetrics.frameTimeMs = deltaTime * 1000.0f;
-            performanceMetrics.fps = 1.0f / deltaTime;
+            performanceMetrics.frameTimeMs = frameDeltaTime * 1000.0f;
+            performanceMetrics.fps = 1.0f / frameDeltaTime;
             
             // Smooth FPS calculation (exponential moving average)
             if (performanceMetrics.smoothedFps == 0.0f) {
@@ -1777,8 +4436,23 @@ public:
             // Process input
             processInput();
             
-            // Update
-            update();
+            // Update：固定步长推进，剩余时间累积到下一帧
+            deltaTime = 1.0f / config.simulationRate;
+            simAccumulator += frameDeltaTime;
+            int steps = 0;
+            while (simAccumulator >= deltaTime && steps < MAX_SIM_STEPS_PER_FRAME) {
+                update();
+                simAccumulator -= deltaTime;
+                steps++;
+            }
+            if (steps == MAX_SIM_STEPS_PER_FRAME) {
+                simAccumulator = std::min(simAccumulator, deltaTime); // 跟不上时放慢模拟，而不是越积越多
+            }
+            interpolationAlpha = simAccumulator / deltaTime;
+            performanceMetrics.simStepsPerFrame = performanceMetrics.simStepsPerFrame * 0.95f + steps * 0.05f;
+            
+            // 海浪按模拟时间变换：本帧推进了模拟才重新变换并上传，否则渲染沿用上次上传的纹理
+            updateOcean(steps > 0);
             
             // Render
             render();
@@ -1808,7 +4482,7 @@ public:
         }
             
         // 相机移动（平滑过渡）
-        float cameraSpeed = config.cameraSpeed * deltaTime;
+        float cameraSpeed = config.cameraSpeed * frameDeltaTime;
         
         // 前后移动
         if (keys[GLFW_KEY_W])
@@ -1829,7 +4503,7 @@ public:
             cameraPos -= cameraUp * cameraSpeed;
             
         // 相机旋转 - 方向键
-        float rotateSpeed = 30.0f * deltaTime;
+        float rotateSpeed = 30.0f * frameDeltaTime;
         if (keys[GLFW_KEY_UP])
             cameraPitch += rotateSpeed;
         if (keys[GLFW_KEY_DOWN])
@@ -1854,44 +4528,31 @@ public:
     }
     
     void update() {
-        // Generate new raindrops
-        rainAccumulator += deltaTime;
-        if (rainAccumulator >= config.updateInterval) {
-            rainAccumulator = 0.0f;
-            generateRaindrops();
-        }
-        
-        // 更新雨滴（性能优化：预分配内存）
-        raindrops.reserve(config.rainDensity);
-        for (auto it = raindrops.begin(); it != raindrops.end();) {
-            bool createRipple = it->update(deltaTime);
-            
-            if (createRipple) {
-                // 创建水面涟漪
-                WaterRipple ripple;
-                ripple.init(it->position, it->color);
-                ripples.push_back(ripple);
-                
-                // 播放水面涟漪声音（概率性播放，不是每个涟漪都播放）
-                if (rand() % 100 < 25) { // 降低到25%以减少音频处理负担
-                    playRippleSound(ripple.position);
-                }
-            }
-            
-            if (it->isDead()) {
-                it = raindrops.erase(it);
-            } else {
-                ++it;
-            }
+        performanceMetrics.ripplesCapped = 0;
+        performanceMetrics.ripplesMerged = 0;
+        performanceMetrics.aggregatedImpacts = 0;
+        if (config.gpuRaindrops) {
+            updateGpuRaindrops();
+        } else {
+            updateCpuRaindrops();
         }
         
-        // Update water ripples
-        for (auto it = ripples.begin(); it != ripples.end();) {
-            if (it->update(deltaTime)) {
-                it = ripples.erase(it);
-            } else {
-                ++it;
-            }
+        // 本步内到期的雨滴、涟漪和闪电（本步生成的对象也以步起点计时）
+        retireExpired();
+        
+        // Update water ripples（并行更新，到期的涟漪已由调度器删除）
+        jobs.parallelFor(ripples.count, RIPPLE_JOB_CHUNK, [this](int begin, int end, int) {
+            ripples.update(begin, end, deltaTime);
+        });
+        
+        // 本步的撞击已写入脉冲列表，推进水面高度场
+        updateHeightfield();
+        
+        // 远处聚合场按时间常数衰减（格子数固定）
+        float aggregateDecay = std::exp(-deltaTime / RIPPLE_AGGREGATE_DECAY);
+        for (size_t c = 0; c < aggregateEnergy.size(); c++) {
+            aggregateEnergy[c] *= aggregateDecay;
+            aggregateColor[c] *= aggregateDecay;
         }
         
         // Update star twinkling
@@ -1906,8 +4567,8 @@ public:
             // If cloud moves out of view, reposition on the other side
             if (cloud.position.x > POND_SIZE) {
                 cloud.position.x = -POND_SIZE;
-                cloud.position.z = -POND_SIZE/2 + static_cast<float>(rand()) / RAND_MAX * POND_SIZE;
-                cloud.opacity = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.3f;
+                cloud.position.z = -POND_SIZE/2 + sceneryRng.uniform() * POND_SIZE;
+                cloud.opacity = 0.2f + sceneryRng.uniform() * 0.3f;
             }
         }
         
@@ -1927,64 +4588,327 @@ public:
                 generateLightning();
                 lightningTimer = 0.0f;
                 // 下次闪电的随机间隔
-                nextLightningTime = config.lightningFrequency + (static_cast<float>(rand()) / RAND_MAX) * config.lightningFrequency;
+                nextLightningTime = config.lightningFrequency + (lightningRng.uniform()) * config.lightningFrequency;
             }
             
-            // 更新现有闪电（优化：使用reserve避免频繁内存分配）
-            for (auto it = lightnings.begin(); it != lightnings.end();) {
-                bool shouldKeep = it->update(deltaTime);
-                if (!shouldKeep) {
-                    it = lightnings.erase(it);
-                } else {
-                    ++it;
+            // 更新现有闪电
+            for (auto& lightning : lightnings) {
+                lightning.update(deltaTime);
+            }
+        }
+        
+        simulationTime += deltaTime;
+    }
+    
+    static uint64_t timerTick(double time) {
+        return static_cast<uint64_t>(time * TIMER_TICKS_PER_SECOND);
+    }
+    
+    // 在 simulationTime + lifetime 时刻到期
+    void scheduleExpiry(float lifetime, TimerKind kind, int id, uint32_t generation = 0) {
+        timers.schedule(timerTick(simulationTime + lifetime), kind, id, generation);
+    }
+    
+    // 推进调度器到本步结束，按类型处理到期条目（删除都是交换删除，编号回收到各自的空闲链表）
+    void retireExpired() {
+        firedTimers.clear();
+        timers.advance(timerTick(simulationTime + deltaTime), firedTimers);
+        performanceMetrics.timersFired = static_cast<int>(firedTimers.size());
+        
+        raindropHits.clear();
+        raindropExpired.clear();
+        for (const TimingWheel::Entry& entry : firedTimers) {
+            switch (entry.kind) {
+                case TIMER_RAINDROP_IMPACT:
+                case TIMER_RAINDROP_EXPIRE: {
+                    // GPU后端运行时CPU雨滴不再积分，到期后直接回收，不产生撞击
+                    bool impact = entry.kind == TIMER_RAINDROP_IMPACT && !config.gpuRaindrops;
+                    (impact ? raindropHits : raindropExpired).push_back(raindrops.indexOf(entry.id));
+                    break;
+                }
+                case TIMER_RIPPLE: {
+                    // 条目保存的是句柄，涟漪已被其他途径删除（槽位代数已变）时忽略
+                    RippleHandle handle;
+                    handle.slot = entry.id;
+                    handle.generation = entry.generation;
+                    int i = ripples.indexOf(handle);
+                    if (i >= 0) ripples.remove(i);
+                    break;
+                }
+                case TIMER_LIGHTNING: {
+                    int i = lightningIds.indexOf(entry.id);
+                    if (i != static_cast<int>(lightnings.size()) - 1) {
+                        std::swap(lightnings[i], lightnings.back());
+                        lightningIds.move(lightnings[i].id, i);
+                    }
+                    lightnings.pop_back();
+                    lightningIds.release(entry.id);
+                    break;
                 }
             }
         }
+        
+        // 涟漪不移动，删除后按新下标重建网格；本步新生成的涟漪在 spawnImpact 中追加，网格项与涟漪下标一致
+        rippleGrid.clear();
+        for (int i = 0; i < ripples.count; i++) {
+            rippleGrid.insert(ripples.posX[i], ripples.posZ[i]);
+        }
+        
+        // 落水的雨滴按下标顺序生成涟漪和声音，结果与条目在格子中的顺序无关
+        std::sort(raindropHits.begin(), raindropHits.end());
+        std::sort(raindropExpired.begin(), raindropExpired.end());
+        for (int i : raindropHits) {
+            glm::vec3 impactPosition = raindrops.position(i);
+            impactPosition.y = WATER_HEIGHT;
+            spawnImpact(impactPosition, raindrops.colorIndex[i]);
+        }
+        
+        // 雨滴池交换删除，拖尾槽位回到空闲链表
+        raindrops.removeSorted(raindropHits.data(), static_cast<int>(raindropHits.size()),
+                               raindropExpired.data(), static_cast<int>(raindropExpired.size()));
     }
     
-    void generateRaindrops() {
-        int raindropsToGenerate = config.rainDensity / 4; // 生成数量
+    void updateCpuRaindrops() {
+        // Generate new raindrops：按每秒生成数精确累积，小数部分留到下一步
+        emissionAccumulator += config.rainDensity * RAIN_DROPS_PER_DENSITY * deltaTime;
+        int raindropsToGenerate = static_cast<int>(emissionAccumulator);
+        emissionAccumulator -= raindropsToGenerate;
+        raindrops.stepStart = simulationTime;
+        generateRaindrops(raindropsToGenerate);
+        
+        // 近/中层每步积分；远层每 FAR_UPDATE_STRIDE 步才积分一次，每个雨滴都积分到本步末尾
+        raindrops.lodFarDepth = config.lodFarDepth;
+        farPhase = (farPhase + 1) % FAR_UPDATE_STRIDE;
+        bool farStep = farPhase == 0;
+        int nearCount = raindrops.farBegin;
+        int farCount = farStep ? raindrops.count - nearCount : 0;
+        
+        auto integrateStart = std::chrono::high_resolution_clock::now();
+        integrateRaindropRange(0, nearCount, true);
+        auto farStart = std::chrono::high_resolution_clock::now();
+        integrateRaindropRange(nearCount, nearCount + farCount, false);
+        auto integrateEnd = std::chrono::high_resolution_clock::now();
+        float nearMs = std::chrono::duration<float, std::milli>(farStart - integrateStart).count();
+        float farMs = std::chrono::duration<float, std::milli>(integrateEnd - farStart).count();
+        performanceMetrics.raindropUpdateMs = performanceMetrics.raindropUpdateMs * 0.95f + (nearMs + farMs) * 0.05f;
+        performanceMetrics.nearUpdateMs = performanceMetrics.nearUpdateMs * 0.95f + nearMs * 0.05f;
+        if (farStep) {
+            performanceMetrics.farUpdateMs = performanceMetrics.farUpdateMs * 0.9f + farMs * 0.1f;
+        }
         
-        for (int i = 0; i < raindropsToGenerate; ++i) {  
-            if (rand() % 100 < 75) { // 稍微降低生成概率以提高性能
-                Raindrop raindrop;
-                
-                // 改进的位置生成策略 - 创造更好的层次感
-                float cameraDistance = glm::length(cameraPos);
-                float nearRadius = cameraDistance * 0.3f;   // 近距离范围
-                float farRadius = cameraDistance * 1.5f;    // 远距离范围
-                
-                // 随机选择距离层次
-                float layerChoice = static_cast<float>(rand()) / RAND_MAX;
-                float radius, height;
+        // 按新的深度重新划分近层和远层（落水和过期的雨滴随后由调度器回收）
+        int midCount = raindrops.reclassify(config.lodMidDepth);
+        lodCounts[LOD_NEAR] = raindrops.farBegin - midCount;
+        lodCounts[LOD_MID] = midCount;
+        lodCounts[LOD_FAR] = raindrops.count - raindrops.farBegin;
+    }
+    
+    // 分块并行积分 [rangeBegin, rangeEnd) 到本步末尾。每个雨滴按自己已积分到的时刻计算步长：
+    // 远层通常落后 FAR_UPDATE_STRIDE 步，刚生成或刚换层的雨滴落后得少；已积分到同一时刻的连续雨滴一起交给内核
+    void integrateRaindropRange(int rangeBegin, int rangeEnd, bool detailed) {
+        double stepEnd = simulationTime + deltaTime;
+        jobs.parallelFor(rangeEnd - rangeBegin, RAINDROP_JOB_CHUNK,
+                         [this, rangeBegin, stepEnd, detailed](int chunkBegin, int chunkEnd, int) {
+            int end = rangeBegin + chunkEnd;
+            for (int begin = rangeBegin + chunkBegin; begin < end; ) {
+                double from = raindrops.integratedTime[begin];
+                int runEnd = begin + 1;
+                while (runEnd < end && raindrops.integratedTime[runEnd] == from) runEnd++;
+                float stepTime = static_cast<float>(stepEnd - from);
                 
-                if (layerChoice < 0.4f) {
-                    // 40% 概率生成近距离大雨滴
-                    radius = nearRadius;
-                    height = 15.0f + static_cast<float>(rand()) / RAND_MAX * 25.0f;
-                } else if (layerChoice < 0.7f) {
-                    // 30% 概率生成中距离雨滴
-                    radius = (nearRadius + farRadius) * 0.5f;
-                    height = 25.0f + static_cast<float>(rand()) / RAND_MAX * 35.0f;
-                } else {
-                    // 30% 概率生成远距离小雨滴
-                    radius = farRadius;
-                    height = 35.0f + static_cast<float>(rand()) / RAND_MAX * 50.0f;
+                // 拖尾记录的是积分前的位置（远层没有拖尾）
+                if (detailed) {
+                    for (int i = begin; i < runEnd; i++) {
+                        raindrops.updateTrail(i, stepTime);
+                    }
                 }
-                
-                // 在圆形区域内随机生成位置
-                float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * glm::pi<float>();
-                float distance = static_cast<float>(rand()) / RAND_MAX * radius;
-                
-                float x = cameraPos.x + distance * cos(angle);
-                float z = cameraPos.z + distance * sin(angle);
-                float y = cameraPos.y + height;
-                
-                // 随机颜色
-                int colorIndex = rand() % config.raindropColors.size();
-                
-                raindrop.init(glm::vec3(x, y, z), config.raindropColors[colorIndex], this);
-                raindrops.push_back(raindrop);
+                raindrops.savePositions(begin, runEnd);
+                raindropKernel(raindrops, begin, runEnd, stepTime, cameraPos, detailed);
+                std::fill(raindrops.integratedTime.begin() + begin, raindrops.integratedTime.begin() + runEnd, stepEnd);
+                begin = runEnd;
+            }
+        });
+    }
+    
+    void updateGpuRaindrops() {
+        if (gpuRaindrops.capacity == 0 && !gpuRaindrops.init(GPU_RAINDROP_CAPACITY)) {
+            std::cerr << "GPU雨滴模拟初始化失败，回退到CPU模拟" << std::endl;
+            gpuRaindrops.release();
+            config.gpuRaindrops = false;
+            return;
+        }
+        auto submitStart = std::chrono::high_resolution_clock::now();
+        
+        // 回读几帧前的撞击（连同上一步阻塞回读的），按固定步长抽样生成涟漪和声音
+        gpuRaindrops.harvestImpacts();
+        int impactCount = static_cast<int>(gpuRaindrops.impacts.size());
+        int stride = std::max(1, (impactCount + config.gpuMaxImpactsPerFrame - 1) / config.gpuMaxImpactsPerFrame);
+        for (int i = 0; i < impactCount; i += stride) {
+            const glm::vec4& impact = gpuRaindrops.impacts[i];
+            spawnImpact(glm::vec3(impact), static_cast<int>(impact.w));
+        }
+        gpuRaindrops.clearImpacts();
+        
+        gpuRaindrops.activeCount = std::min(config.gpuRaindropCount, gpuRaindrops.capacity);
+        gpuRaindrops.simulate(deltaTime, cameraPos, static_cast<int>(config.raindropColors.size()));
+        
+        // GPU后端的CPU开销：回读、生成涟漪和提交绘制命令
+        float submitMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - submitStart).count();
+        performanceMetrics.raindropUpdateMs = performanceMetrics.raindropUpdateMs * 0.95f + submitMs * 0.05f;
+    }
+    
+    void updateHeightfield() {
+        if (!config.waveHeightfield) return;
+        if (heightfield.resolution != config.heightfieldResolution) {
+            heightfield.release();
+            if (!heightfield.init(config.heightfieldResolution)) {
+                std::cerr << "水面高度场初始化失败，已关闭" << std::endl;
+                heightfield.release();
+                config.waveHeightfield = false;
+                return;
+            }
+        }
+        heightfieldTimer.begin();
+        heightfield.simulate(deltaTime, config.heightfieldWaveSpeed, config.heightfieldDamping);
+        heightfieldTimer.end();
+        performanceMetrics.heightfieldImpulses = heightfield.impulseCount;
+    }
+    
+    // 分辨率、波块或风速改变时重建频谱和纹理；多个模拟步只在最后一步的末尾变换一次
+    void updateOcean(bool advanced) {
+        if (!config.oceanFft) return;
+        bool rebuilt = false;
+        if (ocean.resolution != config.oceanResolution || ocean.patchSize != config.oceanPatchSize ||
+            oceanWindSpeed != config.oceanWindSpeed) {
+            oceanWindSpeed = config.oceanWindSpeed;
+            ocean.init(config.oceanResolution, config.oceanPatchSize, config.oceanWindSpeed,
+                       glm::vec2(1.0f, 0.35f), 1.0f, CounterRng(sceneSeed, RNG_STREAM_OCEAN), jobs);
+            glDeleteTextures(1, &oceanTexture);
+            glGenTextures(1, &oceanTexture);
+            glBindTexture(GL_TEXTURE_2D, oceanTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, ocean.resolution, ocean.resolution, 0, GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            rebuilt = true;
+        }
+        if (!advanced && !rebuilt) return;
+        ocean.evaluate(static_cast<float>(simulationTime), jobs, fftKernel);
+        
+        // 远处水面按 mipmap 采样，每次上传后重新生成
+        auto uploadStart = std::chrono::high_resolution_clock::now();
+        glBindTexture(GL_TEXTURE_2D, oceanTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ocean.resolution, ocean.resolution, GL_RGBA, GL_FLOAT, ocean.texels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        float uploadMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - uploadStart).count();
+        oceanUploadMs = oceanUploadMs == 0.0f ? uploadMs : oceanUploadMs * 0.95f + uploadMs * 0.05f;
+    }
+    
+    // 格子中心到相机的距离超过聚合距离
+    bool isAggregateCell(int cell) const {
+        glm::vec2 center = rippleGrid.cellCenter(cell);
+        glm::vec3 offset = glm::vec3(center.x, WATER_HEIGHT, center.y) - cameraPos;
+        return glm::dot(offset, offset) > config.rippleAggregateDistance * config.rippleAggregateDistance;
+    }
+    
+    // 雨滴落水：生成涟漪并播放声音
+    void spawnImpact(const glm::vec3& position, int colorIndex) {
+        // Play water entry sound
+        playRaindropSound(position);
+        
+        // 高度场不受涟漪上限影响（开销与撞击数无关）
+        if (config.waveHeightfield && heightfield.resolution > 0) {
+            heightfield.addImpulse(position, config.heightfieldImpulse, 1.5f);
+        }
+        
+        // 播放水面涟漪声音（概率性播放，不是每个涟漪都播放）；与下面的聚合、合并和涟漪上限无关
+        if (audioRng.nextInt(100) < 25) { // 降低到25%以减少音频处理负担
+            playRippleSound(position);
+        }
+        
+        // 远处格子只累加聚合场能量，不生成单个涟漪
+        int cell = rippleGrid.cellOf(position.x, position.z);
+        if (config.rippleAggregation && isAggregateCell(cell)) {
+            aggregateEnergy[cell] += 1.0f;
+            aggregateColor[cell] += config.raindropColors[colorIndex];
+            performanceMetrics.aggregatedImpacts++;
+            return;
+        }
+        
+        // 落在刚生成的涟漪（不到 RIPPLE_MERGE_AGE）附近的撞击并入该涟漪，密集区域不再叠加几乎重合的环
+        if (config.rippleMergeRadius > 0.0f) {
+            bool merged = false;
+            rippleGrid.queryRadius(position.x, position.z, config.rippleMergeRadius, [&](int ripple) {
+                merged = merged || ripples.lifetime[ripple] < RIPPLE_MERGE_AGE;
+            });
+            if (merged) {
+                performanceMetrics.ripplesMerged++;
+                return;
+            }
+        }
+        
+        // 创建水面涟漪（所在格子已满或池已满时跳过，避免密集区域的涟漪无限叠加）
+        if (ripples.full() || rippleGrid.cellCount(cell) >= config.maxRipplesPerCell) {
+            performanceMetrics.ripplesCapped++;
+            return;
+        }
+        int ripple = ripples.add(position, config.raindropColors[colorIndex], rippleRng);
+        RippleHandle handle = ripples.handle(ripple);
+        scheduleExpiry(ripples.deathTime(ripple), TIMER_RIPPLE, handle.slot, handle.generation);
+        rippleGrid.insert(ripples.posX[ripple], ripples.posZ[ripple]);
+    }
+    
+    void generateRaindrops(int raindropsToGenerate) {
+        for (int i = 0; i < raindropsToGenerate; ++i) {  
+            if (raindrops.full()) break;
+            
+            // 改进的位置生成策略 - 创造更好的层次感
+            float cameraDistance = glm::length(cameraPos);
+            float nearRadius = cameraDistance * 0.3f;   // 近距离范围
+            float farRadius = cameraDistance * 1.5f;    // 远距离范围
+            
+            // 随机选择距离层次
+            float layerChoice = spawnRng.uniform();
+            float radius, height;
+            
+            if (layerChoice < 0.4f) {
+                // 40% 概率生成近距离大雨滴
+                radius = nearRadius;
+                height = 15.0f + spawnRng.uniform() * 25.0f;
+            } else if (layerChoice < 0.7f) {
+                // 30% 概率生成中距离雨滴
+                radius = (nearRadius + farRadius) * 0.5f;
+                height = 25.0f + spawnRng.uniform() * 35.0f;
+            } else {
+                // 30% 概率生成远距离小雨滴
+                radius = farRadius;
+                height = 35.0f + spawnRng.uniform() * 50.0f;
+            }
+            
+            // 在圆形区域内随机生成位置
+            float angle = spawnRng.uniform() * 2.0f * glm::pi<float>();
+            float distance = spawnRng.uniform() * radius;
+            
+            float x = cameraPos.x + distance * cos(angle);
+            float z = cameraPos.z + distance * sin(angle);
+            float y = cameraPos.y + height;
+            
+            // 随机颜色
+            int colorIndex = spawnRng.nextInt(static_cast<int>(config.raindropColors.size()));
+            
+            int drop = raindrops.spawn(glm::vec3(x, y, z), colorIndex, spawnRng);
+            
+            // 本步起开始积分：lifetime 达到落水时间或寿命时到期，以先到者为准
+            float impactTime = raindrops.impactTime(drop);
+            float lifespan = raindrops.lifespan[drop];
+            if (impactTime <= lifespan) {
+                scheduleExpiry(impactTime, TIMER_RAINDROP_IMPACT, raindrops.trailSlot[drop]);
+            } else {
+                scheduleExpiry(lifespan, TIMER_RAINDROP_EXPIRE, raindrops.trailSlot[drop]);
             }
         }
     }
@@ -1995,39 +4919,87 @@ public:
         
         // 随机闪电起点（天空中的位置）
         glm::vec3 startPos(
-            cameraPos.x + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 400.0f,
-            cameraPos.y + 100.0f + static_cast<float>(rand()) / RAND_MAX * 100.0f,
-            cameraPos.z + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 400.0f
+            cameraPos.x + (lightningRng.uniform() - 0.5f) * 400.0f,
+            cameraPos.y + 100.0f + lightningRng.uniform() * 100.0f,
+            cameraPos.z + (lightningRng.uniform() - 0.5f) * 400.0f
         );
         
         // 随机闪电终点（地面或水面附近）
         glm::vec3 endPos(
-            startPos.x + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 100.0f,
-            WATER_HEIGHT + 5.0f + static_cast<float>(rand()) / RAND_MAX * 20.0f,
-            startPos.z + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 100.0f
+            startPos.x + (lightningRng.uniform() - 0.5f) * 100.0f,
+            WATER_HEIGHT + 5.0f + lightningRng.uniform() * 20.0f,
+            startPos.z + (lightningRng.uniform() - 0.5f) * 100.0f
         );
         
-        lightning.generate(startPos, endPos);
-        lightnings.push_back(lightning);
+        lightning.generate(startPos, endPos, lightningRng);
+        lightning.id = lightningIds.acquire(static_cast<int>(lightnings.size()));
+        scheduleExpiry(lightning.duration, TIMER_LIGHTNING, lightning.id);
+        lightnings.push_back(std::move(lightning));
     }
     
     void render() {
-        // 清空缓冲
-        glClearColor(0.01f, 0.02f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        performanceMetrics.uniformUploads = Shader::uploadCount;
+        performanceMetrics.uniformsSkipped = Shader::skippedCount;
+        Shader::uploadCount = Shader::skippedCount = 0;
         
         // 视图/投影矩阵（性能优化：避免重复计算）
         static glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
         
+        // 反射在主场景之前刷新，主场景的剔除结果随后覆盖反射用的列表
+        if (config.planarReflection) {
+            renderReflection(view, projection);
+        }
+        
+        bool oit = config.transparencyMode == TRANSPARENCY_WEIGHTED_OIT;
+        if (oit) {
+            ensureRenderTargets();
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        }
+        
+        // 清空缓冲
+        glClearColor(0.01f, 0.02f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        auto sceneStart = std::chrono::high_resolution_clock::now();
+        cullScene(projection * view, visible);
+        performanceMetrics.culledRaindrops = visible.culledRaindrops;
+        performanceMetrics.culledRipples = visible.culledRipples;
+        performanceMetrics.culledStars = visible.culledStars;
+        float cullMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - sceneStart).count();
+        performanceMetrics.cullMs = performanceMetrics.cullMs * 0.95f + cullMs * 0.05f;
+        aggregateFarRipples();
+        
         // 渲染顺序：先天空、再月亮和星星、然后水面、最后雨滴、波纹和闪电
         renderSky(view, projection);
         renderMoon(view, projection);
-        renderStars(view, projection);
+        renderStars(view, projection, visible);
+        int rippleMode = config.rippleShading;
+        if (rippleMode == RIPPLE_SHADING_ANALYTIC) {
+            auto rippleStart = std::chrono::high_resolution_clock::now();
+            packRippleTiles();
+            recordRippleCpuMs(rippleMode, rippleStart);
+        }
+        waterTimers[rippleMode].begin();
         renderWater(view, projection);
-        renderRaindrops(view, projection);
-        renderRipples(view, projection);
-        renderLightning(view, projection);
+        waterTimers[rippleMode].end();
+        renderTransparent(view, projection, oit);
+        
+        // 按剔除开关分别记录，界面上显示两者之差
+        float sceneMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - sceneStart).count();
+        float& smoothedSceneMs = performanceMetrics.sceneCpuMs[config.frustumCulling ? 1 : 0];
+        smoothedSceneMs = smoothedSceneMs == 0.0f ? sceneMs : smoothedSceneMs * 0.95f + sceneMs * 0.05f;
+        
+        // 合成结果复制到默认帧缓冲，界面直接画在上面
+        if (oit) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, renderTargetWidth, renderTargetHeight,
+                              0, 0, renderTargetWidth, renderTargetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
         
         // 渲染ImGui界面
         renderUI();
@@ -2041,6 +5013,445 @@ public:
         #endif
     }
 
+    // 视锥剔除：为雨滴、涟漪和星星生成可见下标列表，关闭剔除时列表包含全部对象
+    // GPU雨滴后端的数据不在CPU上，不参与剔除
+    void cullScene(const glm::mat4& viewProjection, CullOutput& out) {
+        Frustum frustum = Frustum::fromMatrix(viewProjection);
+        
+        // 雨滴：近/中层带拖尾，使用更大的包围球；位置用当前步，插值偏移远小于包围球半径
+        if (config.frustumCulling) {
+            out.nearCount = cullKernel(frustum, raindrops.posX.data(), raindrops.posY.data(), raindrops.posZ.data(),
+                                       nullptr, TRAIL_CULL_RADIUS, 0, raindrops.farBegin, out.raindrops.data());
+            int visibleFarCount = cullKernel(frustum, raindrops.posX.data(), raindrops.posY.data(), raindrops.posZ.data(),
+                                             nullptr, RAINDROP_CULL_RADIUS, raindrops.farBegin, raindrops.count,
+                                             out.raindrops.data() + out.nearCount);
+            out.raindropCount = out.nearCount + visibleFarCount;
+        } else {
+            for (int i = 0; i < raindrops.count; i++) out.raindrops[i] = i;
+            out.nearCount = raindrops.farBegin;
+            out.raindropCount = raindrops.count;
+        }
+        out.culledRaindrops = raindrops.count - out.raindropCount;
+        
+        // 涟漪：包围球覆盖最外层的放大和波浪高度偏移
+        int rippleCount = ripples.count;
+        resizeCullBuffers(rippleCount);
+        for (int i = 0; i < rippleCount; i++) {
+            cullX[i] = ripples.posX[i];
+            cullY[i] = WATER_HEIGHT + 0.02f;
+            cullZ[i] = ripples.posZ[i];
+            cullRadius[i] = ripples.outerRadius(i, interpolationAlpha, config.rippleRings) + std::abs(ripples.waveHeight[i]);
+        }
+        out.culledRipples = cullList(frustum, rippleCount, cullRadius.data(), 0.0f, out.ripples);
+        
+        // 星星：只绘制一个点，包围球取很小的半径
+        int starCount = static_cast<int>(stars.size());
+        resizeCullBuffers(starCount);
+        for (int i = 0; i < starCount; i++) {
+            cullX[i] = stars[i].position.x;
+            cullY[i] = stars[i].position.y;
+            cullZ[i] = stars[i].position.z;
+        }
+        out.culledStars = cullList(frustum, starCount, nullptr, 1.0f, out.stars);
+    }
+    
+    // 远处涟漪聚合：相机移动后落在远处格子里的单个涟漪从可见列表移除，透明度并入格子强度；
+    // 每个有能量的远处格子生成一个聚合场实例
+    void aggregateFarRipples() {
+        int cellCount = static_cast<int>(aggregateEnergy.size());
+        aggregateInstances.clear();
+        performanceMetrics.aggregatedRipples = 0;
+        performanceMetrics.aggregateCells = 0;
+        if (!config.rippleAggregation) return;
+        
+        for (int c = 0; c < cellCount; c++) {
+            aggregateFar[c] = isAggregateCell(c) ? 1 : 0;
+        }
+        
+        // 本帧临时强度：先放入衰减后的撞击能量，再加上远处单个涟漪
+        rippleFieldEnergy.assign(aggregateEnergy.begin(), aggregateEnergy.end());
+        rippleFieldColor.assign(aggregateColor.begin(), aggregateColor.end());
+        size_t kept = 0;
+        for (int r : visible.ripples) {
+            int cell = rippleGrid.cellOf(ripples.posX[r], ripples.posZ[r]);
+            if (!aggregateFar[cell]) {
+                visible.ripples[kept++] = r;
+                continue;
+            }
+            float opacity = ripples.interpolatedOpacity(r, interpolationAlpha);
+            rippleFieldEnergy[cell] += opacity;
+            rippleFieldColor[cell] += ripples.color[r] * opacity;
+            performanceMetrics.aggregatedRipples++;
+        }
+        visible.ripples.resize(kept);
+        
+        float halfSize = rippleGrid.cellSize() * 0.5f;
+        for (int c = 0; c < cellCount; c++) {
+            float energy = rippleFieldEnergy[c];
+            if (!aggregateFar[c] || energy < 0.05f) continue;
+            AggregateInstance instance;
+            glm::vec2 center = rippleGrid.cellCenter(c);
+            float intensity = 1.0f - std::exp(-energy / RIPPLE_AGGREGATE_SATURATION);
+            instance.cell = glm::vec4(center.x, center.y, halfSize, intensity);
+            instance.color = glm::vec4(rippleFieldColor[c] / energy, 0.0f);
+            aggregateInstances.push_back(instance);
+        }
+        performanceMetrics.aggregateCells = static_cast<int>(aggregateInstances.size());
+    }
+    
+    void resizeCullBuffers(int count) {
+        if (static_cast<int>(cullX.size()) >= count) return;
+        cullX.resize(count);
+        cullY.resize(count);
+        cullZ.resize(count);
+        cullRadius.resize(count);
+    }
+    
+    // 对 cullX/Y/Z 中的前 count 个包围球做剔除，返回被剔除的数量
+    int cullList(const Frustum& frustum, int count, const float* radii, float radius, std::vector<int>& visible) {
+        visible.resize(count);
+        if (!config.frustumCulling) {
+            for (int i = 0; i < count; i++) visible[i] = i;
+            return 0;
+        }
+        int visibleCount = cullKernel(frustum, cullX.data(), cullY.data(), cullZ.data(), radii, radius, 0, count, visible.data());
+        visible.resize(visibleCount);
+        return count - visibleCount;
+    }
+    
+    void recordRippleCpuMs(int mode, std::chrono::high_resolution_clock::time_point start) {
+        float ms = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        float& smoothedMs = performanceMetrics.rippleCpuMs[mode];
+        smoothedMs = smoothedMs == 0.0f ? ms : smoothedMs * 0.95f + ms * 0.05f;
+    }
+    
+    static void createTextureBuffer(unsigned int& buffer, unsigned int& texture, GLenum format) {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    
+    template <typename T>
+    static void uploadTextureBuffer(unsigned int buffer, const std::vector<T>& data) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        // 空缓冲不能作为纹理缓冲的存储，至少保留一个元素
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(data.size(), 1) * sizeof(T), data.empty() ? nullptr : data.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    
+    // 解析涟漪着色：把可见涟漪（超过上限时按已存在时间保留最新的）写入 rippleData，并按世界空间分块计数排序
+    // 每个涟漪登记到外层环（半径 ×1.2）的包围正方形覆盖的所有块
+    void packRippleTiles() {
+        int visibleCount = static_cast<int>(visible.ripples.size());
+        int shadedCount = std::min(visibleCount, config.maxShadedRipples);
+        performanceMetrics.shadedRipples = shadedCount;
+        performanceMetrics.ripplesOverCap = visibleCount - shadedCount;
+        
+        // 池中下标顺序与生成顺序无关（删除会把末尾的涟漪移入空位），按 lifetime 选出最年轻的 shadedCount 个
+        shadedRippleOrder = visible.ripples;
+        if (shadedCount < visibleCount) {
+            std::nth_element(shadedRippleOrder.begin(), shadedRippleOrder.begin() + shadedCount, shadedRippleOrder.end(),
+                             [this](int a, int b) { return ripples.lifetime[a] < ripples.lifetime[b]; });
+        }
+        
+        const int tileCount = RIPPLE_TILE_RESOLUTION * RIPPLE_TILE_RESOLUTION;
+        const float tilesPerUnit = RIPPLE_TILE_RESOLUTION / POND_SIZE;
+        rippleData.resize(shadedCount * 2);
+        rippleTileBounds.resize(shadedCount);
+        rippleTiles.assign(tileCount, glm::ivec2(0));
+        for (int k = 0; k < shadedCount; k++) {
+            int r = shadedRippleOrder[k];
+            float x = ripples.posX[r];
+            float z = ripples.posZ[r];
+            float radius = ripples.interpolatedRadius(r, interpolationAlpha);
+            rippleData[k * 2] = glm::vec4(x, z, radius, ripples.pulseFrequency[r]);
+            rippleData[k * 2 + 1] = glm::vec4(ripples.color[r], ripples.interpolatedOpacity(r, interpolationAlpha));
+            
+            float reach = radius * 1.2f;
+            auto tileOf = [&](float coordinate) {
+                return glm::clamp(static_cast<int>(std::floor((coordinate + POND_SIZE / 2) * tilesPerUnit)), 0, RIPPLE_TILE_RESOLUTION - 1);
+            };
+            glm::ivec4 bounds(tileOf(x - reach), tileOf(z - reach), tileOf(x + reach), tileOf(z + reach));
+            rippleTileBounds[k] = bounds;
+            for (int tz = bounds.y; tz <= bounds.w; tz++) {
+                for (int tx = bounds.x; tx <= bounds.z; tx++) {
+                    rippleTiles[tz * RIPPLE_TILE_RESOLUTION + tx].y++;
+                }
+            }
+        }
+        
+        // 前缀和得到每块的起点，再按涟漪顺序填入编号
+        int offset = 0;
+        for (auto& tile : rippleTiles) {
+            tile.x = offset;
+            offset += tile.y;
+            tile.y = 0;
+        }
+        rippleTileIndices.resize(offset);
+        for (int k = 0; k < shadedCount; k++) {
+            const glm::ivec4& bounds = rippleTileBounds[k];
+            for (int tz = bounds.y; tz <= bounds.w; tz++) {
+                for (int tx = bounds.x; tx <= bounds.z; tx++) {
+                    glm::ivec2& tile = rippleTiles[tz * RIPPLE_TILE_RESOLUTION + tx];
+                    rippleTileIndices[tile.x + tile.y++] = k;
+                }
+            }
+        }
+        performanceMetrics.rippleTileEntries = offset;
+        
+        uploadTextureBuffer(rippleDataBuffer, rippleData);
+        uploadTextureBuffer(rippleTileBuffer, rippleTiles);
+        uploadTextureBuffer(rippleIndexBuffer, rippleTileIndices);
+    }
+    
+    // 透明物体：雨滴（含拖尾）、涟漪和闪电
+    void renderTransparent(const glm::mat4& view, const glm::mat4& projection, bool oit) {
+        int mode = oit ? TRANSPARENCY_WEIGHTED_OIT : TRANSPARENCY_SORTED;
+        auto cpuStart = std::chrono::high_resolution_clock::now();
+        // 几何方式的涟漪在透明物体中绘制，按涟漪方式分开计时，才能与解析方式的水面耗时对比
+        GpuTimer& timer = transparentTimers[mode][config.rippleShading];
+        timer.begin();
+        
+        if (oit) {
+            // 累积颜色与 -log(透射率) 都用加法混合，绘制顺序不影响结果；保留深度测试但不写深度
+            glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+            const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 0, zero);
+            glClearBufferfv(GL_COLOR, 1, zero);
+            glDepthMask(GL_FALSE);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            oitActive = true;
+        }
+        
+        if (config.gpuRaindrops && gpuRaindrops.capacity > 0) {
+            gpuRaindrops.render(view, projection, cameraPos, totalTime, config.raindropColors, oitActive, interpolationAlpha);
+        } else {
+            performanceMetrics.trailSegments = renderRaindrops(view, projection, visible);
+        }
+        if (config.rippleShading == RIPPLE_SHADING_GEOMETRY) {
+            auto rippleStart = std::chrono::high_resolution_clock::now();
+            renderRipples(view, projection);
+            recordRippleCpuMs(RIPPLE_SHADING_GEOMETRY, rippleStart);
+        }
+        renderRippleField(view, projection);
+        renderLightning(view, projection);
+        
+        if (oit) {
+            oitActive = false;
+            glDepthMask(GL_TRUE);
+            
+            // 合成：加权平均颜色按 1 - 透射率 混合到不透明场景上
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+            glDisable(GL_DEPTH_TEST);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            
+            oitResolveShader->use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, oitAccumTexture);
+            oitResolveShader->setInt("accumTexture", 0);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, oitRevealageTexture);
+            oitResolveShader->setInt("revealageTexture", 1);
+            
+            glBindVertexArray(fullscreenVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            
+            glActiveTexture(GL_TEXTURE0);
+            glEnable(GL_DEPTH_TEST);
+        }
+        
+        timer.end();
+        float cpuMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - cpuStart).count();
+        float& smoothedCpuMs = performanceMetrics.transparentCpuMs[mode];
+        smoothedCpuMs = smoothedCpuMs == 0.0f ? cpuMs : smoothedCpuMs * 0.95f + cpuMs * 0.05f;
+    }
+    
+    // 按当前帧缓冲大小（重新）创建OIT所需的渲染目标
+    void ensureRenderTargets() {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == renderTargetWidth && height == renderTargetHeight && sceneFBO != 0)
+            return;
+        
+        releaseRenderTargets();
+        renderTargetWidth = width;
+        renderTargetHeight = height;
+        
+        // 共享深度缓冲：透明物体需要与不透明场景做深度测试
+        glGenRenderbuffers(1, &sceneDepthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, sceneDepthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        
+        sceneColorTexture = createRenderTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+        glGenFramebuffers(1, &sceneFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRBO);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "场景帧缓冲不完整" << std::endl;
+        }
+        
+        // 累积颜色需要浮点格式，透射率以 -log 形式累加，单通道即可
+        oitAccumTexture = createRenderTexture(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+        oitRevealageTexture = createRenderTexture(GL_R16F, GL_RED, GL_HALF_FLOAT, width, height);
+        glGenFramebuffers(1, &oitFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oitAccumTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oitRevealageTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepthRBO);
+        const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "OIT帧缓冲不完整" << std::endl;
+        }
+        
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    
+    // 反射目标的分辨率为窗口的 reflectionScale 倍，窗口或比例改变时重建
+    void ensureReflectionTarget() {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        width = std::max(1, static_cast<int>(width * config.reflectionScale));
+        height = std::max(1, static_cast<int>(height * config.reflectionScale));
+        if (width == reflectionWidth && height == reflectionHeight && reflectionFBO != 0)
+            return;
+        
+        releaseReflectionTarget();
+        reflectionWidth = width;
+        reflectionHeight = height;
+        
+        // 水面按扰动后的坐标采样，使用线性过滤
+        reflectionColorTexture = createRenderTexture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+        glBindTexture(GL_TEXTURE_2D, reflectionColorTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        
+        glGenRenderbuffers(1, &reflectionDepthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, reflectionDepthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        
+        glGenFramebuffers(1, &reflectionFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, reflectionFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, reflectionColorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, reflectionDepthRBO);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "反射帧缓冲不完整" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        reflectionAge = config.reflectionInterval; // 新目标立即刷新
+    }
+    
+    void releaseReflectionTarget() {
+        if (reflectionFBO == 0) return;
+        glDeleteFramebuffers(1, &reflectionFBO);
+        glDeleteTextures(1, &reflectionColorTexture);
+        glDeleteRenderbuffers(1, &reflectionDepthRBO);
+        reflectionFBO = reflectionColorTexture = reflectionDepthRBO = 0;
+    }
+    
+    // 镜像相机：视图矩阵右乘关于水面 y = WATER_HEIGHT 的反射。场景中没有开启背面剔除，不需要翻转绕序；
+    // 水面以上的物体才会被画到，水面本身和涟漪不进入反射。
+    // 两次刷新之间水面用上次刷新时的视图投影矩阵重投影（水面上的点在两台镜像相机下对应同一个反射点）
+    // 斜近平面（Lengyel）：把投影的近平面替换为观察空间中的 plane（世界空间平面经 view 变换），
+    // plane 负侧的几何被裁掉；只改变深度行，屏幕坐标不变。相机本身须在 plane 负侧（真实相机在水面以上），否则返回原投影
+    static glm::mat4 obliqueNearPlane(const glm::mat4& projection, const glm::mat4& view, const glm::vec4& worldPlane) {
+        glm::vec4 plane = glm::transpose(glm::inverse(view)) * worldPlane;
+        if (plane.w >= 0.0f) return projection;
+        glm::vec4 corner = glm::inverse(projection) * glm::vec4(glm::sign(plane.x), glm::sign(plane.y), 1.0f, 1.0f);
+        glm::vec4 scaled = plane * (2.0f / glm::dot(plane, corner));
+        glm::mat4 result = projection;
+        for (int column = 0; column < 4; column++) {
+            result[column][2] = scaled[column] - projection[column][3];
+        }
+        return result;
+    }
+    
+    void renderReflection(const glm::mat4& view, const glm::mat4& projection) {
+        ensureReflectionTarget();
+        if (++reflectionAge < config.reflectionInterval) return;
+        reflectionAge = 0;
+        
+        auto cpuStart = std::chrono::high_resolution_clock::now();
+        reflectionTimer.begin();
+        
+        glm::mat4 mirror = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f * WATER_HEIGHT, 0.0f))
+                         * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+        glm::mat4 reflectionView = view * mirror;
+        // 近平面换成水面，水下的雨滴拖尾和闪电不会出现在倒影中；天空不随相机平移，仍用原投影
+        glm::mat4 clippedProjection = obliqueNearPlane(projection, reflectionView, glm::vec4(0.0f, 1.0f, 0.0f, -WATER_HEIGHT));
+        reflectionViewProjection = clippedProjection * reflectionView;
+        
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, reflectionFBO);
+        glViewport(0, 0, reflectionWidth, reflectionHeight);
+        glClearColor(0.01f, 0.02f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        // 按镜像视锥剔除到反射自己的列表，主视图的可见列表和剔除统计不受影响
+        cullScene(reflectionViewProjection, reflectionVisible);
+        renderSky(reflectionView, projection);
+        renderMoon(reflectionView, clippedProjection);
+        renderStars(reflectionView, clippedProjection, reflectionVisible);
+        
+        // 透明物体直接按排序混合方式绘制，不使用OIT目标
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (config.gpuRaindrops && gpuRaindrops.capacity > 0) {
+            gpuRaindrops.render(reflectionView, clippedProjection, cameraPos, totalTime, config.raindropColors, false, interpolationAlpha);
+        } else {
+            renderRaindrops(reflectionView, clippedProjection, reflectionVisible);
+        }
+        renderLightning(reflectionView, clippedProjection);
+        
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        
+        reflectionTimer.end();
+        float cpuMs = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - cpuStart).count();
+        float& smoothedCpuMs = performanceMetrics.reflectionCpuMs;
+        smoothedCpuMs = smoothedCpuMs == 0.0f ? cpuMs : smoothedCpuMs * 0.95f + cpuMs * 0.05f;
+        performanceMetrics.reflectionUpdates++;
+    }
+    
+    unsigned int createRenderTexture(GLint internalFormat, GLenum format, GLenum type, int width, int height) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+    
+    void releaseRenderTargets() {
+        if (sceneFBO == 0) return;
+        glDeleteFramebuffers(1, &sceneFBO);
+        glDeleteFramebuffers(1, &oitFBO);
+        glDeleteTextures(1, &sceneColorTexture);
+        glDeleteTextures(1, &oitAccumTexture);
+        glDeleteTextures(1, &oitRevealageTexture);
+        glDeleteRenderbuffers(1, &sceneDepthRBO);
+        sceneFBO = oitFBO = 0;
+    }
+    
     void renderWater(const glm::mat4& view, const glm::mat4& projection) {
         waterShader->use();
         
@@ -2059,196 +5470,353 @@ public:
         glBindTexture(GL_TEXTURE_2D, waterDuDvTexture);
         waterShader->setInt("dudvMap", 1);
         
+        // 平面反射关闭时仍使用程序化的月亮和星星倒影
+        bool planarReflection = config.planarReflection && reflectionFBO != 0;
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, waterReflectionTexture);
+        glBindTexture(GL_TEXTURE_2D, planarReflection ? reflectionColorTexture : waterReflectionTexture);
         waterShader->setInt("reflectionMap", 2);
+        waterShader->setBool("planarReflection", planarReflection);
+        waterShader->setMat4("reflectionViewProjection", reflectionViewProjection);
         
         // 设置水面属性 - 优化波浪效果
         waterShader->setFloat("time", totalTime);
         waterShader->setVec3("viewPos", cameraPos);
         waterShader->setFloat("waveStrength", config.waveStrength * 3.0f); // 适度增强波浪，避免过于夸张
-        waterShader->setFloat("waveSpeed", 1.8f); // 适当加快波浪速度
+        waterShader->setFloat("waveSpeed", WATER_WAVE_SPEED); // 适当加快波浪速度
         waterShader->setFloat("waterDepth", 0.9f); // 进一步加深水色
         
-        // 使用索引绘制水面
+        bool heightfieldEnabled = config.waveHeightfield && heightfield.resolution > 0;
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, heightfieldEnabled ? heightfield.texture() : 0);
+        glActiveTexture(GL_TEXTURE0);
+        waterShader->setInt("heightfield", 3);
+        waterShader->setBool("heightfieldEnabled", heightfieldEnabled);
+        waterShader->setFloat("heightfieldScale", config.heightfieldScale);
+        waterShader->setFloat("pondSize", POND_SIZE);
+        
+        bool oceanEnabled = config.oceanFft && ocean.resolution > 0;
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D, oceanEnabled ? oceanTexture : 0);
+        glActiveTexture(GL_TEXTURE0);
+        waterShader->setInt("oceanMap", 7);
+        waterShader->setBool("oceanEnabled", oceanEnabled);
+        waterShader->setFloat("oceanPatchSize", ocean.patchSize);
+        waterShader->setFloat("oceanAmplitude", config.oceanAmplitude * config.waveStrength);
+        
+        // 波形图集只取决于固定的波形参数，只在叠加正弦波路径首次使用时烘焙一次（默认的 FFT 海浪不需要）
+        bool bakedWaves = config.bakedWaves && !oceanEnabled;
+        if (bakedWaves && waveAtlas.surfaceTexture == 0) {
+            waveAtlas.bake(jobs, WATER_WAVE_SPEED);
+            std::cout << "Wave atlas baked in " << waveAtlas.bakeMs << " ms" << std::endl;
+        }
+        glActiveTexture(GL_TEXTURE8);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, waveAtlas.surfaceTexture);
+        glActiveTexture(GL_TEXTURE9);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, waveAtlas.detailTexture);
+        glActiveTexture(GL_TEXTURE0);
+        waterShader->setInt("waveAtlas", 8);
+        waterShader->setInt("detailAtlas", 9);
+        waterShader->setBool("bakedWaves", bakedWaves);
+        waterShader->setFloat("waveAtlasTile", WaveAtlas::TILE);
+        waterShader->setVec3("waveAtlasRanges", glm::vec3(WaveAtlas::HEIGHT_RANGE, WaveAtlas::SLOPE_RANGE, WaveAtlas::DETAIL_RANGE));
+        waterShader->setVec3("waveAtlasLayers", WaveAtlas::layerBlend(totalTime, WaveAtlas::SURFACE_PERIOD, WaveAtlas::SURFACE_LAYERS));
+        waterShader->setVec3("detailAtlasLayers", WaveAtlas::layerBlend(totalTime, WaveAtlas::DETAIL_PERIOD, WaveAtlas::DETAIL_LAYERS));
+        
+        // 解析涟漪：分块列表和涟漪参数（几何方式下不读取）
+        bool analyticRipples = config.rippleShading == RIPPLE_SHADING_ANALYTIC;
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_BUFFER, rippleDataTexture);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_BUFFER, rippleTileTexture);
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_BUFFER, rippleIndexTexture);
+        glActiveTexture(GL_TEXTURE0);
+        waterShader->setInt("rippleData", 4);
+        waterShader->setInt("rippleTiles", 5);
+        waterShader->setInt("rippleTileIndices", 6);
+        waterShader->setBool("analyticRipples", analyticRipples);
+        waterShader->setInt("rippleTileResolution", RIPPLE_TILE_RESOLUTION);
+        waterShader->setFloat("rippleVisibility", config.rippleVisibility);
+        
+        // clipmap：第 L 层中心对齐到 2 倍格距，内层中心相对本层偏移 0 或 1 格，选用对应挖空位置的环
+        // 与池塘不相交或挖空处已覆盖整个池塘的层不绘制
+        glm::vec2 camera(cameraPos.x, cameraPos.z);
+        float halfPond = POND_SIZE * 0.5f;
+        int triangles = 0;
+        glm::vec2 innerOrigin(0.0f);
+        waterShader->setInt("clipmapGrid", CLIPMAP_GRID);
         glBindVertexArray(waterVAO);
-        glDrawElements(GL_TRIANGLES, waterIndexCount, GL_UNSIGNED_INT, 0);
+        for (int level = 0; level < CLIPMAP_LEVELS; level++) {
+            float cellSize = CLIPMAP_BASE_CELL * float(1 << level);
+            glm::vec2 origin = glm::floor(camera / (2.0f * cellSize)) * (2.0f * cellSize);
+            float halfExtent = CLIPMAP_GRID * 0.5f * cellSize;
+            glm::vec2 hole = (innerOrigin - origin) / cellSize;
+            glm::vec2 holeMin = origin + (hole - CLIPMAP_GRID * 0.25f) * cellSize;
+            glm::vec2 holeMax = origin + (hole + CLIPMAP_GRID * 0.25f) * cellSize;
+            innerOrigin = origin;
+            
+            bool outside = glm::any(glm::greaterThan(glm::abs(origin), glm::vec2(halfPond + halfExtent)));
+            bool covered = level > 0 && holeMin.x <= -halfPond && holeMin.y <= -halfPond && holeMax.x >= halfPond && holeMax.y >= halfPond;
+            if (outside || covered) continue;
+            
+            waterShader->setVec2("clipmapOrigin", origin);
+            waterShader->setFloat("clipmapCellSize", cellSize);
+            waterShader->setBool("clipmapStitch", level < CLIPMAP_LEVELS - 1);
+            int first = 0, count = clipmapFullCount;
+            if (level > 0) {
+                first = clipmapRingOffset[static_cast<int>(hole.x) + 2 * static_cast<int>(hole.y)];
+                count = clipmapRingCount;
+            }
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(first * sizeof(unsigned int)));
+            triangles += count / 3;
+        }
         glBindVertexArray(0);
+        performanceMetrics.waterTriangles = triangles;
     }
     
-    void renderRaindrops(const glm::mat4& view, const glm::mat4& projection) {
-        // 首先渲染流星拖尾效果 - 增强视觉效果
-        trailShader->use();
-        trailShader->setMat4("view", view);
-        trailShader->setMat4("projection", projection);
-        
-        // 启用线条宽度设置
-        glEnable(GL_LINE_SMOOTH);
-        glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-        
-        glBindVertexArray(lightningVAO); // 重用闪电的线条VAO
-        
-        for (const auto& raindrop : raindrops) {
-            if (!raindrop.visible || raindrop.state > 0 || raindrop.trailPositions.empty())
+    // 绘制 cull 中的可见雨滴，返回拖尾线段数
+    int renderRaindrops(const glm::mat4& view, const glm::mat4& projection, const CullOutput& cull) {
+        // 首先渲染流星拖尾效果 - 所有拖尾线段写入同一个流式缓冲，一次绘制
+        // 每个顶点自带透明度和宽度，几何着色器在屏幕空间把线段扩展为四边形
+        // 只有近/中层雨滴有拖尾，中层只绘制最新的几条记录
+        trailVertices.clear();
+        for (int v = 0; v < cull.nearCount; v++) {
+            int d = cull.raindrops[v];
+            int trailLength = raindrops.trailLength[d];
+            if (raindrops.layerDepth[d] >= config.lodMidDepth)
+                trailLength = std::min(trailLength, MID_TRAIL_LENGTH);
+            if (trailLength < 2)
                 continue;
-                
-            // 渲染每条雨滴的拖尾
-            for (int i = 0; i < raindrop.trailPositions.size() - 1; i++) {
-                // 计算拖尾衰减
-                float trailFactor = 1.0f - (float(i) / raindrop.maxTrailLength);
-                float alpha = raindrop.trailAlphas[i] * trailFactor * 0.8f;
-                
-                if (alpha < 0.05f) continue; // 跳过过于透明的部分
-                
-                // 更新线条顶点数据
-                std::vector<float> lineVertices = {
-                    raindrop.trailPositions[i].x, raindrop.trailPositions[i].y, raindrop.trailPositions[i].z,
-                    raindrop.trailPositions[i+1].x, raindrop.trailPositions[i+1].y, raindrop.trailPositions[i+1].z
-                };
-                
-                glBindBuffer(GL_ARRAY_BUFFER, lightningVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, lineVertices.size() * sizeof(float), lineVertices.data());
-                
-                // 设置模型矩阵
-                glm::mat4 model = glm::mat4(1.0f);
-                trailShader->setMat4("model", model);
-                
-                // 设置拖尾颜色和透明度 - 增强流星效果
-                glm::vec3 trailColor = raindrop.color * (1.2f + 0.3f * sin(totalTime * 5.0f));
-                trailShader->setVec3("rippleColor", trailColor);
-                trailShader->setFloat("opacity", alpha);
-                
-                // 动态线条宽度
-                float lineWidth = raindrop.size * (2.0f - raindrop.layerDepth) * trailFactor * 2.0f;
-                glLineWidth(std::max(lineWidth, 1.0f));
-                
-                // 绘制拖尾线段
-                glDrawArrays(GL_LINES, 0, 2);
+            
+            glm::vec3 raindropColor = config.raindropColors[raindrops.colorIndex[d]];
+            float maxLength = raindrops.maxTrailLength[d];
+            float baseWidth = raindrops.size[d] * (2.0f - raindrops.layerDepth[d]) * 2.0f;
+            
+            // 计算每条记录的顶点属性（越旧越淡越细）
+            TrailVertex samples[TrailPool::SLOT_LENGTH];
+            for (int k = 0; k < trailLength; k++) {
+                float trailFactor = 1.0f - (float(k) / maxLength);
+                samples[k].position = raindrops.trails.positions[raindrops.trailSample(d, k)];
+                samples[k].alpha = raindrops.trailAlpha(d, k) * trailFactor * 0.8f;
+                samples[k].color = raindropColor;
+                samples[k].width = std::max(baseWidth * trailFactor, 1.0f); // 动态线条宽度
+            }
+            
+            for (int k = 0; k < trailLength - 1; k++) {
+                if (samples[k].alpha < 0.05f) continue; // 跳过过于透明的部分
+                trailVertices.push_back(samples[k]);
+                trailVertices.push_back(samples[k + 1]);
             }
         }
         
-        glDisable(GL_LINE_SMOOTH);
+        if (!trailVertices.empty()) {
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            
+            trailShader->use();
+            trailShader->setMat4("view", view);
+            trailShader->setMat4("projection", projection);
+            trailShader->setVec2("viewportSize", glm::vec2(viewport[2], viewport[3]));
+            trailShader->setFloat("colorPulse", 1.2f + 0.3f * sin(totalTime * 5.0f)); // 增强流星效果
+            trailShader->setBool("oitEnabled", oitActive);
+            
+            // 每帧重新分配存储后整体上传
+            glBindVertexArray(trailVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, trailVBO);
+            glBufferData(GL_ARRAY_BUFFER, trailVertices.size() * sizeof(TrailVertex), trailVertices.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            
+            glDrawArrays(GL_LINES, 0, static_cast<int>(trailVertices.size()));
+            glBindVertexArray(0);
+        }
         
-        // 然后渲染雨滴主体 - 改进的点渲染
+        // 然后渲染雨滴主体 - 所有雨滴合并为一次 GL_POINTS 绘制
         raindropShader->use();
         raindropShader->setMat4("view", view);
         raindropShader->setMat4("projection", projection);
+        raindropShader->setVec3("cameraPos", cameraPos);
+        raindropShader->setFloat("time", totalTime);
+        raindropShader->setBool("oitEnabled", oitActive);
+        for (int c = 0; c < std::min(static_cast<int>(config.raindropColors.size()), 8); c++) {
+            raindropShader->set(raindropColorUniforms[c], config.raindropColors[c]);
+        }
         
         glEnable(GL_PROGRAM_POINT_SIZE);
         glEnable(GL_POINT_SMOOTH); // 启用点的抗锯齿
         glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
         
-        glBindVertexArray(raindropVAO);
+        // 填充顶点属性，大小/闪烁/荧光效果在 raindrop.vert 中计算
+        // 远层雨滴每 FAR_UPDATE_STRIDE 步才积分一次，插值跨度相应放大
+        raindropVertices.clear();
+        float farAlpha = (farPhase + interpolationAlpha) / FAR_UPDATE_STRIDE;
+        auto raindropAlpha = [this, farAlpha](int i) {
+            return i < raindrops.farBegin ? interpolationAlpha : farAlpha;
+        };
+        auto appendRaindrop = [this, &raindropAlpha](int i) {
+            RaindropVertex vertex;
+            vertex.positionLifetime = glm::vec4(raindrops.interpolatedPosition(i, raindropAlpha(i)), raindrops.lifetime[i]);
+            vertex.attributes = glm::vec4(raindrops.size[i], raindrops.twinkleSpeed[i], raindrops.colorIndex[i], 0.0f);
+            raindropVertices.push_back(vertex);
+        };
         
-        // 按距离排序雨滴以实现正确的透明度混合
-        std::vector<std::pair<float, const Raindrop*>> sortedRaindrops;
-        for (const auto& raindrop : raindrops) {
-            if (raindrop.visible && raindrop.state == 0) {
-                float distance = glm::length(raindrop.position - cameraPos);
-                sortedRaindrops.push_back({distance, &raindrop});
+        if (oitActive) {
+            // 顺序无关透明度：直接按池中顺序提交
+            for (int v = 0; v < cull.raindropCount; v++) {
+                appendRaindrop(cull.raindrops[v]);
             }
-        }
-        
-        // 从远到近排序
-        std::sort(sortedRaindrops.begin(), sortedRaindrops.end(), 
-                  [](const auto& a, const auto& b) { return a.first > b.first; });
-        
-        for (const auto& [distance, raindrop] : sortedRaindrops) {
-            // 设置模型矩阵
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, raindrop->position);
-            raindropShader->setMat4("model", model);
-            
-            // 基于距离的动态大小调整 - 显著改善层次感
-            float baseSizeScale = 100.0f / std::max(distance, 10.0f); // 防止除零
-            float finalSize = raindrop->size * baseSizeScale;
-            
-            // 近处雨滴明显更大，远处雨滴相对较小
-            if (raindrop->layerDepth < 0.3f) {
-                finalSize *= 3.0f; // 近处雨滴3倍大小
-            } else if (raindrop->layerDepth < 0.6f) {
-                finalSize *= 2.0f; // 中等距离2倍大小
+        } else {
+            // 按距离排序雨滴以实现正确的透明度混合
+            sortedRaindrops.clear();
+            for (int v = 0; v < cull.raindropCount; v++) {
+                int i = cull.raindrops[v];
+                float distance = glm::length(raindrops.interpolatedPosition(i, raindropAlpha(i)) - cameraPos);
+                sortedRaindrops.push_back({distance, i});
             }
             
-            // 设置雨滴属性
-            glm::vec3 enhancedColor = raindrop->color * raindrop->brightness;
-            // 添加荧光效果
-            float glowEffect = 1.0f + 0.4f * sin(totalTime * raindrop->twinkleSpeed + raindrop->position.x);
-            enhancedColor *= glowEffect;
+            // 从远到近排序
+            std::sort(sortedRaindrops.begin(), sortedRaindrops.end(), 
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
             
-            raindropShader->setVec3("raindropColor", enhancedColor);
-            raindropShader->setFloat("raindropSize", finalSize);
-            raindropShader->setFloat("brightness", raindrop->brightness);
-            
-            // 绘制雨滴
-            glDrawArrays(GL_POINTS, 0, 1);
+            for (const auto& [distance, i] : sortedRaindrops) {
+                appendRaindrop(i);
+            }
         }
         
+        // 重新分配存储（orphaning）后上传，避免等待上一帧的绘制
+        glBindVertexArray(raindropVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, raindropVBO);
+        glBufferData(GL_ARRAY_BUFFER, RAINDROP_POOL_CAPACITY * sizeof(RaindropVertex), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, raindropVertices.size() * sizeof(RaindropVertex), raindropVertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        
+        glDrawArrays(GL_POINTS, 0, static_cast<int>(raindropVertices.size()));
+        
         glDisable(GL_POINT_SMOOTH);
         glDisable(GL_PROGRAM_POINT_SIZE);
         glBindVertexArray(0);
+        return static_cast<int>(trailVertices.size() / 2);
+    }
+    
+    // 实例属性指向实例缓冲中从 first 开始的记录（GL 3.3 没有 baseInstance，按层次分段绘制时移动属性起点）
+    void bindRippleInstances(size_t first) {
+        size_t base = first * sizeof(RippleInstance);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(RippleInstance), (void*)(base + offsetof(RippleInstance, centerRadius)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(RippleInstance), (void*)(base + offsetof(RippleInstance, colorOpacity)));
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(RippleInstance), (void*)(base + offsetof(RippleInstance, wave)));
     }
     
     void renderRipples(const glm::mat4& view, const glm::mat4& projection) {
+        rippleMesh.ensure(config.rippleRings);
+        
+        // 每个可见涟漪一条实例记录；三层的偏移、旋转、缩放和脉动在 ripple.vert 中计算
+        // 按最外层环的投影半径（像素）选择细节层次，再按层次计数排序，每个层次一次实例化绘制
+        // 按当前视口高度换算（窗口缩放后与 SCR_HEIGHT 不同）
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        float pixelsPerUnit = projection[1][1] * viewport[3] * 0.5f;
+        int lodCounts[RippleMesh::LOD_COUNT] = {};
+        rippleLods.resize(visible.ripples.size());
+        for (size_t v = 0; v < visible.ripples.size(); v++) {
+            int r = visible.ripples[v];
+            float outerRadius = ripples.outerRadius(r, interpolationAlpha, config.rippleRings);
+            float viewDepth = -(view * glm::vec4(ripples.position(r), 1.0f)).z;
+            // 相机在涟漪范围内时投影半径没有意义，使用最精细的层次
+            int lod = viewDepth > outerRadius ? rippleMesh.lodFor(outerRadius * pixelsPerUnit / viewDepth) : 0;
+            rippleLods[v] = lod;
+            lodCounts[lod]++;
+        }
+        int lodFirst[RippleMesh::LOD_COUNT];
+        int lodCursor[RippleMesh::LOD_COUNT];
+        int rippleVertices = 0;
+        for (int l = 0, first = 0; l < RippleMesh::LOD_COUNT; l++) {
+            lodFirst[l] = lodCursor[l] = first;
+            first += lodCounts[l];
+            performanceMetrics.rippleLodCounts[l] = lodCounts[l];
+            rippleVertices += lodCounts[l] * 3 * rippleMesh.vertexCount[l];
+        }
+        performanceMetrics.rippleVertices = rippleVertices;
+        
+        rippleInstances.resize(visible.ripples.size());
+        for (size_t v = 0; v < visible.ripples.size(); v++) {
+            int r = visible.ripples[v];
+            RippleInstance& instance = rippleInstances[lodCursor[rippleLods[v]]++];
+            instance.centerRadius = glm::vec4(ripples.position(r), ripples.interpolatedRadius(r, interpolationAlpha));
+            instance.colorOpacity = glm::vec4(ripples.color[r], ripples.interpolatedOpacity(r, interpolationAlpha));
+            instance.wave = glm::vec4(ripples.waveHeight[r], ripples.pulseFrequency[r], 0.0f, 0.0f);
+        }
+        if (rippleInstances.empty()) return;
+        
         rippleShader->use();
         
         // 设置变换矩阵
         rippleShader->setMat4("view", view);
         rippleShader->setMat4("projection", projection);
+        rippleShader->setFloat("time", totalTime);
+        rippleShader->setFloat("visibility", config.rippleVisibility);
+        rippleShader->setBool("oitEnabled", oitActive);
         
-        // 增强的透明度混合设置
+        // 增强的透明度混合设置（OIT累积时混合状态由 renderTransparent 统一设置）
         glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE); // 改为加法混合以增强可见性
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // 改为加法混合以增强可见性
+        }
         
         // 启用线条抗锯齿
         glEnable(GL_LINE_SMOOTH);
         glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
         
-        // 遍历所有水波 - 改进的涟漪渲染
+        // 重新分配存储后上传，同一层次的涟漪（三层）合并为一次实例化绘制
         glBindVertexArray(rippleVAO);
-        for (const auto& ripple : ripples) {
-            // 多层涟漪渲染以增强效果
-            for (int layer = 0; layer < 3; layer++) {
-                glm::mat4 model = glm::mat4(1.0f);
-                
-                // 添加水面波浪高度偏移
-                glm::vec3 ripplePos = ripple.position;
-                ripplePos.y += ripple.getCurrentWaveHeight() * sin(totalTime * 2.0f + layer);
-                model = glm::translate(model, ripplePos);
-                
-                // 每层略微不同的旋转和大小
-                float layerRotation = totalTime * (0.1f + layer * 0.05f);
-                model = glm::rotate(model, layerRotation, glm::vec3(0.0f, 1.0f, 0.0f));
-                
-                float layerScale = ripple.radius * (1.0f + layer * 0.1f);
-                model = glm::scale(model, glm::vec3(layerScale));
-                
-                rippleShader->setMat4("model", model);
-                
-                // 多层颜色效果
-                float layerIntensity = 1.0f - (layer * 0.3f);
-                float colorPulse = 1.0f + 0.3f * sin(totalTime * ripple.pulseFrequency + layer);
-                glm::vec3 layerColor = ripple.color * colorPulse * layerIntensity * config.rippleVisibility;
-                
-                // 增强涟漪亮度和对比度
-                layerColor = glm::min(layerColor * 2.0f, glm::vec3(1.0f));
-                
-                rippleShader->setVec3("rippleColor", layerColor);
-                
-                // 动态透明度 - 更强的初始透明度
-                float layerOpacity = ripple.opacity * layerIntensity * 0.8f;
-                rippleShader->setFloat("opacity", layerOpacity);
-                
-                // 绘制水波环
-                glDrawArrays(GL_TRIANGLES, 0, 6 * 256 * config.rippleRings);
-            }
+        glBindBuffer(GL_ARRAY_BUFFER, rippleInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, rippleInstances.size() * sizeof(RippleInstance), rippleInstances.data(), GL_STREAM_DRAW);
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(RippleMesh::RESTART_INDEX);
+        for (int l = 0; l < RippleMesh::LOD_COUNT; l++) {
+            if (lodCounts[l] == 0) continue;
+            bindRippleInstances(lodFirst[l]);
+            glDrawElementsInstanced(GL_TRIANGLE_STRIP, rippleMesh.indexCount[l], GL_UNSIGNED_INT,
+                                    (void*)(rippleMesh.indexOffset[l] * sizeof(unsigned int)), lodCounts[l] * 3);
         }
+        bindRippleInstances(0);
+        glDisable(GL_PRIMITIVE_RESTART);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
         
         glDisable(GL_LINE_SMOOTH);
         
         // 恢复标准透明度混合
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        glBindVertexArray(0);
+    }
+    
+    // 远处涟漪聚合场：每个格子一个四边形，环纹在 ripple_field.frag 中按世界坐标程序化生成
+    void renderRippleField(const glm::mat4& view, const glm::mat4& projection) {
+        if (aggregateInstances.empty()) return;
+        
+        rippleFieldShader->use();
+        rippleFieldShader->setMat4("view", view);
+        rippleFieldShader->setMat4("projection", projection);
+        rippleFieldShader->setFloat("time", totalTime);
+        rippleFieldShader->setFloat("surfaceHeight", WATER_HEIGHT + 0.02f);
+        rippleFieldShader->setFloat("visibility", config.rippleVisibility);
+        rippleFieldShader->setBool("oitEnabled", oitActive);
+        
+        glEnable(GL_BLEND);
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // 与单个涟漪相同的加法混合
+        }
+        
+        glBindVertexArray(aggregateVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, aggregateVBO);
+        glBufferData(GL_ARRAY_BUFFER, aggregateInstances.size() * sizeof(AggregateInstance), aggregateInstances.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<int>(aggregateInstances.size()));
         glBindVertexArray(0);
+        
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
     }
     
     // New: render sky
@@ -2324,7 +5892,7 @@ public:
     }
     
     // New: render stars
-    void renderStars(const glm::mat4& view, const glm::mat4& projection) {
+    void renderStars(const glm::mat4& view, const glm::mat4& projection, const CullOutput& cull) {
         starShader->use();
         
         // Set transformation matrices
@@ -2335,19 +5903,20 @@ public:
         glEnable(GL_PROGRAM_POINT_SIZE);
         
         // Draw all stars
-        glBindVertexArray(raindropVAO); // Reuse raindrop VAO
+        glBindVertexArray(pointVAO);
         
-        for (const auto& star : stars) {
+        for (int s : cull.stars) {
+            const Star& star = stars[s];
             // Set model matrix
             glm::mat4 model = glm::mat4(1.0f);
             model = glm::translate(model, star.position);
-            starShader->setMat4("model", model);
+            starShader->set(starUniforms.model, model);
             
-            // Set star properties
+            // Set star properties（颜色不变，只在第一颗星上传）
             glm::vec3 starColor(0.9f, 0.9f, 1.0f); // White with slight blue tint
-            starShader->setVec3("raindropColor", starColor);
-            starShader->setFloat("raindropSize", star.size * 2.0f);
-            starShader->setFloat("brightness", star.brightness);
+            starShader->set(starUniforms.color, starColor);
+            starShader->set(starUniforms.size, star.size * 2.0f);
+            starShader->set(starUniforms.brightness, star.brightness);
             
             // Draw star
             glDrawArrays(GL_POINTS, 0, 1);
@@ -2366,12 +5935,15 @@ public:
         lightningShader->use();
         lightningShader->setMat4("view", view);
         lightningShader->setMat4("projection", projection);
+        lightningShader->setBool("oitEnabled", oitActive);
         
         // 启用线条渲染设置
         glEnable(GL_LINE_SMOOTH);
         glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
         glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE); // 加法混合用于闪电发光效果
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // 加法混合用于闪电发光效果
+        }
         
         glBindVertexArray(lightningVAO);
         
@@ -2397,12 +5969,12 @@ public:
                 
                 // 设置模型矩阵
                 glm::mat4 model = glm::mat4(1.0f);
-                lightningShader->setMat4("model", model);
+                lightningShader->set(lightningUniforms.model, model);
                 
                 // 闪电颜色和强度 - 增强亮度
                 glm::vec3 lightningColor = lightning.color * lightning.intensity * config.lightningIntensity * 5.0f;
-                lightningShader->setVec3("lightningColor", lightningColor);
-                lightningShader->setFloat("intensity", lightning.intensity);
+                lightningShader->set(lightningUniforms.color, lightningColor);
+                lightningShader->set(lightningUniforms.intensity, lightning.intensity);
                 
                 // 动态线条宽度 - 增加宽度
                 float lineWidth = lightning.thickness * lightning.intensity * 3.0f;
@@ -2424,13 +5996,13 @@ public:
                     glBufferSubData(GL_ARRAY_BUFFER, 0, lineVertices.size() * sizeof(float), lineVertices.data());
                     
                     glm::mat4 model = glm::mat4(1.0f);
-                    lightningShader->setMat4("model", model);
+                    lightningShader->set(lightningUniforms.model, model);
                     
                     // 光晕颜色 - 逐层衰减但增强基础亮度
                     float glowIntensity = lightning.intensity * (0.8f / glow);
                     glm::vec3 glowColor = lightning.color * glowIntensity * 2.0f;
-                    lightningShader->setVec3("lightningColor", glowColor);
-                    lightningShader->setFloat("intensity", glowIntensity);
+                    lightningShader->set(lightningUniforms.color, glowColor);
+                    lightningShader->set(lightningUniforms.intensity, glowIntensity);
                     
                     // 光晕线条宽度
                     float glowWidth = lightning.thickness * (1.0f + glow * 3.0f) * lightning.intensity;
@@ -2443,7 +6015,9 @@ public:
         
         // 恢复渲染状态
         glDisable(GL_LINE_SMOOTH);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (!oitActive) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
         glBindVertexArray(0);
     }
     
@@ -2464,8 +6038,12 @@ public:
         sprintf(fpsText, "FPS: %.1f", performanceMetrics.smoothedFps);
         ImGui::Text(fpsText);
         
-        ImGui::Text("Raindrops: %lu", raindrops.size());
-        ImGui::Text("Ripples: %lu", ripples.size());
+        if (config.gpuRaindrops) {
+            ImGui::Text("Raindrops (GPU): %d", gpuRaindrops.activeCount);
+        } else {
+            ImGui::Text("Raindrops: %d / %d", raindrops.count, raindrops.capacity);
+        }
+        ImGui::Text("Ripples: %d / %d", ripples.count, ripples.capacity);
         
         ImGui::Separator();
         
@@ -2501,7 +6079,10 @@ public:
             ImGui::SliderFloat("Max Ripple Size", &config.maxRippleSize, 20.0f, 120.0f); // 适度降低最大值以提高性能
             ImGui::SliderFloat("Ripple Visibility", &config.rippleVisibility, 0.5f, 5.0f);
             ImGui::SliderInt("Ripple Rings", &config.rippleRings, 2, 6); // 减少最大环数以提高性能
-            ImGui::SliderFloat("Update Interval", &config.updateInterval, 0.01f, 0.1f);
+            // 环形网格按屏幕大小选用 256/96/32/12 段
+            const int* lodCounts = performanceMetrics.rippleLodCounts;
+            ImGui::Text("Ripple LOD %d / %d / %d / %d  (%d vertices)", lodCounts[0], lodCounts[1], lodCounts[2], lodCounts[3],
+                        performanceMetrics.rippleVertices);
             
             // 涟漪颜色编辑
             if (ImGui::TreeNode("Ripple Colors")) {
@@ -2567,65 +6148,175 @@ public:
             }
         }
         
+        // 性能设置
+        if (ImGui::CollapsingHeader("Performance")) {
+            // 只列出CPU支持的指令集
+            const char* kernelNames[] = { "Auto", "Scalar", "SSE2", "AVX2" };
+            if (ImGui::Combo("Integration Kernel", &config.integrationKernel, kernelNames, cpuSimdLevel + 2)) {
+                SimdLevel level = config.integrationKernel == 0 ? cpuSimdLevel
+                                : static_cast<SimdLevel>(config.integrationKernel - 1);
+                raindropKernel = selectRaindropKernel(level);
+                cullKernel = selectCullKernel(level);
+                fftKernel = selectFftButterflyKernel(level);
+            }
+            ImGui::Text("CPU SIMD: %s", simdLevelName(cpuSimdLevel));
+            
+            // 块划分固定，调整线程数不会改变模拟结果
+            int maxWorkers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+            ImGui::SliderInt("Worker Threads", &config.workerThreads, 0, std::max(maxWorkers, 1));
+            if (ImGui::IsItemDeactivatedAfterEdit()) { // 松开滑块后才重建线程
+                jobs.start(config.workerThreads);
+            }
+            ImGui::Text("Raindrop Update: %.3f ms", performanceMetrics.raindropUpdateMs);
+            ImGui::Text("Timers: %d pending, %d fired last step", timers.size(), performanceMetrics.timersFired);
+            
+            // 细节层次：远层不更新拖尾和摆动，积分频率降低
+            if (ImGui::SliderFloat("LOD Mid Depth", &config.lodMidDepth, 0.0f, 1.0f)) {
+                config.lodFarDepth = std::max(config.lodFarDepth, config.lodMidDepth);
+            }
+            if (ImGui::SliderFloat("LOD Far Depth", &config.lodFarDepth, 0.0f, 1.0f)) {
+                config.lodMidDepth = std::min(config.lodMidDepth, config.lodFarDepth);
+            }
+            ImGui::Text("Near %d  Mid %d  Far %d", lodCounts[LOD_NEAR], lodCounts[LOD_MID], lodCounts[LOD_FAR]);
+            ImGui::Text("Near/Mid %.3f ms  Far %.3f ms (every %d steps)", performanceMetrics.nearUpdateMs,
+                        performanceMetrics.farUpdateMs, FAR_UPDATE_STRIDE);
+            ImGui::Text("Trail Segments: %d", performanceMetrics.trailSegments);
+            ImGui::Text("Water Triangles: %d", performanceMetrics.waterTriangles);
+            
+            // 视锥剔除：场景耗时按开关分别记录，切换后即可对比
+            ImGui::Checkbox("Frustum Culling", &config.frustumCulling);
+            ImGui::Text("Culled: drops %d  ripples %d  stars %d", performanceMetrics.culledRaindrops,
+                        performanceMetrics.culledRipples, performanceMetrics.culledStars);
+            ImGui::Text("Cull %.3f ms  Scene CPU off %.3f / on %.3f ms (saved %+.3f ms)", performanceMetrics.cullMs,
+                        performanceMetrics.sceneCpuMs[0], performanceMetrics.sceneCpuMs[1],
+                        performanceMetrics.sceneCpuMs[0] - performanceMetrics.sceneCpuMs[1]);
+            ImGui::Text("Uniform uploads %d  (unchanged, skipped %d)", performanceMetrics.uniformUploads,
+                        performanceMetrics.uniformsSkipped);
+            
+            // 平面反射：分辨率比例和刷新间隔直接决定开销，耗时只在刷新帧统计
+            ImGui::Checkbox("Planar Reflection", &config.planarReflection);
+            if (config.planarReflection) {
+                ImGui::SliderFloat("Reflection Scale", &config.reflectionScale, 0.125f, 1.0f);
+                ImGui::SliderInt("Reflection Interval", &config.reflectionInterval, 1, 8);
+                ImGui::Text("Reflection %dx%d  CPU %.3f ms  GPU %.3f ms per refresh  (%d refreshes)",
+                            reflectionWidth, reflectionHeight, performanceMetrics.reflectionCpuMs,
+                            reflectionTimer.smoothedMs, performanceMetrics.reflectionUpdates);
+            }
+            
+            // 涟漪网格：每个格子（边长 POND_SIZE / RIPPLE_GRID_RESOLUTION）的涟漪数量上限
+            ImGui::SliderInt("Max Ripples / Cell", &config.maxRipplesPerCell, 1, 64);
+            ImGui::SliderFloat("Ripple Merge Radius", &config.rippleMergeRadius, 0.0f, 10.0f);
+            ImGui::Text("Ripples: %d  (capped last step %d, merged %d)", ripples.count,
+                        performanceMetrics.ripplesCapped, performanceMetrics.ripplesMerged);
+            
+            // 涟漪绘制方式：两种方式的CPU耗时和水面GPU耗时分别记录
+            // 几何方式的GPU开销包含在透明物体耗时中，解析方式则计入水面耗时，因此对比两者之和
+            const char* rippleShadingNames[] = { "Geometry", "Analytic" };
+            ImGui::Combo("Ripple Shading", &config.rippleShading, rippleShadingNames, 2);
+            if (config.rippleShading == RIPPLE_SHADING_ANALYTIC) {
+                ImGui::SliderInt("Max Shaded Ripples", &config.maxShadedRipples, 16, 4096, "%d", ImGuiSliderFlags_Logarithmic);
+                ImGui::Text("Shaded %d  (over cap %d)  tile entries %d", performanceMetrics.shadedRipples,
+                            performanceMetrics.ripplesOverCap, performanceMetrics.rippleTileEntries);
+            }
+            for (int mode = 0; mode < 2; mode++) {
+                float transparentMs = transparentTimers[config.transparencyMode][mode].smoothedMs;
+                ImGui::Text("%-10s ripples CPU %.3f ms  water GPU %.3f ms + transparent GPU %.3f ms = %.3f ms",
+                            rippleShadingNames[mode], performanceMetrics.rippleCpuMs[mode], waterTimers[mode].smoothedMs,
+                            transparentMs, waterTimers[mode].smoothedMs + transparentMs);
+            }
+            
+            // 远处涟漪聚合：超过距离的格子只保留一个强度场
+            ImGui::Checkbox("Far Ripple Aggregation", &config.rippleAggregation);
+            if (config.rippleAggregation) {
+                ImGui::SliderFloat("Aggregate Distance", &config.rippleAggregateDistance, 50.0f, 500.0f);
+                ImGui::Text("Aggregate cells %d  (impacts last step %d, folded ripples %d)", performanceMetrics.aggregateCells,
+                            performanceMetrics.aggregatedImpacts, performanceMetrics.aggregatedRipples);
+            }
+            
+            // 水面高度场：开销只取决于网格分辨率，切换分辨率时重建纹理
+            ImGui::Checkbox("Wave Heightfield", &config.waveHeightfield);
+            if (config.waveHeightfield) {
+                const int resolutions[] = { 128, 256, 512, 1024 };
+                const char* resolutionNames[] = { "128", "256", "512", "1024" };
+                int resolutionIndex = 0;
+                for (int r = 0; r < 4; r++) {
+                    if (resolutions[r] == config.heightfieldResolution) resolutionIndex = r;
+                }
+                if (ImGui::Combo("Heightfield Grid", &resolutionIndex, resolutionNames, 4)) {
+                    config.heightfieldResolution = resolutions[resolutionIndex];
+                }
+                ImGui::SliderFloat("Wave Speed", &config.heightfieldWaveSpeed, 2.0f, 60.0f);
+                ImGui::SliderFloat("Wave Damping", &config.heightfieldDamping, 0.0f, 4.0f);
+                ImGui::SliderFloat("Impact Depth", &config.heightfieldImpulse, 0.0f, 2.0f);
+                ImGui::SliderFloat("Heightfield Scale", &config.heightfieldScale, 0.0f, 4.0f);
+                ImGui::Text("Heightfield GPU %.3f ms  (impacts last step %d)", heightfieldTimer.smoothedMs,
+                            performanceMetrics.heightfieldImpulses);
+            }
+            
+            // FFT 海浪：行/列变换分块并行，每帧上传一次；切换分辨率、波块或风速时重建频谱
+            ImGui::Checkbox("FFT Ocean", &config.oceanFft);
+            if (config.oceanFft) {
+                const int resolutions[] = { 64, 128, 256, 512 };
+                const char* resolutionNames[] = { "64", "128", "256", "512" };
+                int resolutionIndex = 0;
+                for (int r = 0; r < 4; r++) {
+                    if (resolutions[r] == config.oceanResolution) resolutionIndex = r;
+                }
+                if (ImGui::Combo("Ocean Grid", &resolutionIndex, resolutionNames, 4)) {
+                    config.oceanResolution = resolutions[resolutionIndex];
+                }
+                ImGui::SliderFloat("Ocean Patch", &config.oceanPatchSize, 40.0f, 400.0f);
+                ImGui::SliderFloat("Wind Speed", &config.oceanWindSpeed, 2.0f, 30.0f);
+                ImGui::SliderFloat("Ocean Amplitude", &config.oceanAmplitude, 0.0f, 2.0f);
+                ImGui::Text("Ocean CPU ms: spectrum %.3f  rows %.3f  columns %.3f  pack %.3f  upload %.3f",
+                            ocean.spectrumMs, ocean.rowsMs, ocean.columnsMs, ocean.packMs, oceanUploadMs);
+            } else {
+                // 叠加正弦波：采样首次使用时烘焙的循环图集，或逐顶点/逐片元计算三角函数（对比水面GPU耗时）
+                ImGui::Checkbox("Baked Wave Atlas", &config.bakedWaves);
+                if (waveAtlas.surfaceTexture != 0) {
+                    ImGui::Text("Wave atlas baked in %.1f ms", waveAtlas.bakeMs);
+                } else {
+                    ImGui::Text("Wave atlas not baked yet");
+                }
+            }
+            
+            // 固定步长：吞吐量与帧率无关，渲染在最近两步之间插值
+            ImGui::SliderInt("Sim Rate (Hz)", &config.simulationRate, 30, 240);
+            ImGui::Text("Sim Steps / Frame: %.2f  (drops/s %.0f)", performanceMetrics.simStepsPerFrame,
+                        config.rainDensity * RAIN_DROPS_PER_DENSITY);
+            
+            // GPU模拟：雨滴状态常驻显存，CPU只回读撞击
+            ImGui::Separator();
+            ImGui::Checkbox("GPU Raindrops", &config.gpuRaindrops);
+            if (config.gpuRaindrops) {
+                ImGui::SliderInt("GPU Drop Count", &config.gpuRaindropCount, 1024, GPU_RAINDROP_CAPACITY, "%d", ImGuiSliderFlags_Logarithmic);
+                ImGui::SliderInt("Max Impacts / Frame", &config.gpuMaxImpactsPerFrame, 1, 512);
+                ImGui::Text("Impacts: %u (read back %d)", gpuRaindrops.impactsGenerated,
+                            gpuRaindrops.impactsReadBack);
+            }
+            
+            // 透明物体混合方式，两种模式的耗时分别记录以便对比
+            ImGui::Separator();
+            const char* transparencyNames[] = { "Sorted", "Weighted OIT" };
+            ImGui::Combo("Transparency", &config.transparencyMode, transparencyNames, 2);
+            // GPU耗时取当前涟漪方式下的计时
+            int currentRippleMode = config.rippleShading;
+            for (int mode = 0; mode < 2; mode++) {
+                ImGui::Text("%-12s CPU %.3f ms  GPU %.3f ms", transparencyNames[mode],
+                            performanceMetrics.transparentCpuMs[mode], transparentTimers[mode][currentRippleMode].smoothedMs);
+            }
+            ImGui::Text("OIT - Sorted: CPU %+.3f ms  GPU %+.3f ms",
+                        performanceMetrics.transparentCpuMs[TRANSPARENCY_WEIGHTED_OIT] - performanceMetrics.transparentCpuMs[TRANSPARENCY_SORTED],
+                        transparentTimers[TRANSPARENCY_WEIGHTED_OIT][currentRippleMode].smoothedMs - transparentTimers[TRANSPARENCY_SORTED][currentRippleMode].smoothedMs);
+        }
+        
         ImGui::End();
         
         // 渲染ImGui
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
-};
-
-// Raindrop::update method - enhanced with trail effects
-bool Raindrop::update(float deltaTime) {
-    lifetime += deltaTime;
-    
-    // Update distance from camera for layer depth calculation
-    if (simulation) {
-        distanceFromCamera = glm::length(position - simulation->cameraPos);
-        layerDepth = std::min(distanceFromCamera / 200.0f, 1.0f);
-    }
-    
-    // Enhanced twinkling with layer-based variations
-    brightness = 0.7f + 0.3f * sin(lifetime * twinkleSpeed + position.x * 0.1f);
-    brightness *= (1.2f - layerDepth * 0.4f); // 近处雨滴更亮
-    
-    if (state == 0) { // Falling state
-        // Update trail positions before updating main position
-        updateTrail(deltaTime);
-        
-        position += velocity * deltaTime;
-        
-        // Enhanced motion with layer-dependent swaying
-        float swayAmount = 0.1f * (1.0f - layerDepth); // 近处雨滴摆动更明显
-        velocity.x += (cos(lifetime * 3.0f + position.z) * swayAmount - velocity.x * 0.1f) * deltaTime;
-        velocity.z += (sin(lifetime * 2.5f + position.x) * swayAmount - velocity.z * 0.1f) * deltaTime;
-        
-        // Gravity with layer-dependent acceleration
-        float gravityMultiplier = 0.8f + layerDepth * 0.4f; // 远处雨滴受重力影响更大
-        velocity.y -= 2.0f * gravityMultiplier * deltaTime;
-        
-        // Check if hit water surface
-        if (position.y <= WATER_HEIGHT) {
-            state = 1; // Water entry state
-            visible = false;
-            
-            // Play water entry sound
-            if (simulation) {
-                simulation->playRaindropSound(position);
-            }
-            
-            return true; // Tell to create ripple
-        }
-    } else if (state == 1) { // Water entry state
-        // If below water surface, gradually fade
-        brightness -= deltaTime * 3.0f;
-        if (brightness <= 0.0f) {
-            state = 2; // Disappeared state
-        }
-    }
-    
-    return false;
-}
+};
 
 // Write shader files
 void writeShaderFiles() {
@@ -2713,8 +6404,7 @@ void main() {
     // Vertex shader - water (enhanced)
     const char* waterVertexShader = R"(
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoords;
+// 水面网格为以相机为中心的嵌套网格（clipmap），顶点位置由 gl_VertexID 和本层的原点、格距得到，不需要顶点属性
 
 out vec2 TexCoords;
 out vec3 FragPos;
@@ -2726,32 +6416,112 @@ uniform mat4 projection;
 uniform float time;
 uniform float waveStrength;
 uniform float waveSpeed;
+uniform sampler2D heightfield;      // 雨滴撞击的波动方程高度场（r 为高度）
+uniform bool heightfieldEnabled;
+uniform float heightfieldScale;
+uniform float pondSize;
+uniform vec2 clipmapOrigin;         // 本层中心（世界 xz）
+uniform float clipmapCellSize;      // 本层格距
+uniform int clipmapGrid;            // 每层每边的格数
+uniform bool clipmapStitch;         // 外边与更粗的一层相接
+uniform sampler2D oceanMap;         // FFT 海浪（r 高度，g/b 为 x/z 斜率），按波块边长平铺
+uniform bool oceanEnabled;
+uniform float oceanPatchSize;
+uniform float oceanAmplitude;
+uniform sampler2DArray waveAtlas;   // 预烘焙的叠加正弦波（r 高度，g/b 为 x/z 斜率，单位波浪强度，归一化到 [0, 1]）
+uniform bool bakedWaves;
+uniform float waveAtlasTile;        // 图集平铺边长
+uniform vec3 waveAtlasRanges;       // 高度、斜率、片元扰动的取值范围
+uniform vec3 waveAtlasLayers;       // 当前时刻的相邻两层和插值系数
 
-void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+// 相邻两层之间按时间插值，解码为 [-1, 1]
+vec4 sampleWaveAtlas(vec2 p) {
+    vec2 uv = p / waveAtlasTile;
+    vec4 first = textureLod(waveAtlas, vec3(uv, waveAtlasLayers.x), 0.0);
+    vec4 second = textureLod(waveAtlas, vec3(uv, waveAtlasLayers.y), 0.0);
+    return mix(first, second, waveAtlasLayers.z) * 2.0 - 1.0;
+}
+
+// 多层复杂波浪效果 - 增加更多层次
+float surfaceHeight(vec2 p) {
+    if (oceanEnabled) {
+        float height = textureLod(oceanMap, p / oceanPatchSize, 0.0).r * oceanAmplitude;
+        if (heightfieldEnabled) {
+            height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+        }
+        return height;
+    }
     
-    // 多层复杂波浪效果 - 增加更多层次
-    vec3 pos = aPos;
+    if (bakedWaves) {
+        float height = sampleWaveAtlas(p).r * waveAtlasRanges.x * waveStrength;
+        if (heightfieldEnabled) {
+            height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+        }
+        return height;
+    }
     
     // 第一层：大波浪
-    float wave1 = sin(pos.x * 0.08 + time * waveSpeed) * cos(pos.z * 0.08 + time * waveSpeed * 0.8) * waveStrength;
+    float wave1 = sin(p.x * 0.08 + time * waveSpeed) * cos(p.y * 0.08 + time * waveSpeed * 0.8) * waveStrength;
     
     // 第二层：中等波浪
-    float wave2 = sin(pos.x * 0.15 + time * waveSpeed * 1.3) * cos(pos.z * 0.12 + time * waveSpeed * 1.1) * waveStrength * 0.6;
+    float wave2 = sin(p.x * 0.15 + time * waveSpeed * 1.3) * cos(p.y * 0.12 + time * waveSpeed * 1.1) * waveStrength * 0.6;
     
     // 第三层：小波浪
-    float wave3 = sin(pos.x * 0.25 + time * waveSpeed * 1.8) * cos(pos.z * 0.22 + time * waveSpeed * 1.5) * waveStrength * 0.3;
+    float wave3 = sin(p.x * 0.25 + time * waveSpeed * 1.8) * cos(p.y * 0.22 + time * waveSpeed * 1.5) * waveStrength * 0.3;
     
     // 第四层：微波
-    float wave4 = sin(pos.x * 0.4 + time * waveSpeed * 2.2) * cos(pos.z * 0.35 + time * waveSpeed * 2.0) * waveStrength * 0.15;
+    float wave4 = sin(p.x * 0.4 + time * waveSpeed * 2.2) * cos(p.y * 0.35 + time * waveSpeed * 2.0) * waveStrength * 0.15;
     
     // 第五层：细微波纹
-    float wave5 = sin(pos.x * 0.6 + time * waveSpeed * 2.8) * cos(pos.z * 0.55 + time * waveSpeed * 2.5) * waveStrength * 0.08;
+    float wave5 = sin(p.x * 0.6 + time * waveSpeed * 2.8) * cos(p.y * 0.55 + time * waveSpeed * 2.5) * waveStrength * 0.08;
     
-    pos.y = wave1 + wave2 + wave3 + wave4 + wave5;
+    float height = wave1 + wave2 + wave3 + wave4 + wave5;
+    if (heightfieldEnabled) {
+        height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+    }
+    return height;
+}
+
+vec2 clampToPond(vec2 p) {
+    return clamp(p, vec2(-0.5 * pondSize), vec2(0.5 * pondSize));
+}
+
+void main() {
+    int side = clipmapGrid + 1;
+    ivec2 g = ivec2(gl_VertexID % side, gl_VertexID / side);
+    vec2 grid = clipmapOrigin + vec2(g - ivec2(clipmapGrid / 2)) * clipmapCellSize;
+    
+    // 池塘外的顶点压到边界上（三角形退化，不产生可见面积）
+    vec3 pos = vec3(clampToPond(grid), 0.0).xzy;
+    FragPos = vec3(model * vec4(pos, 1.0));
+    TexCoords = pos.xz / pondSize + 0.5;
+    
+    // 接缝：外边上的奇数顶点不在粗一层的网格上，高度取两侧偶数顶点的平均，与粗一层的边完全重合
+    pos.y = surfaceHeight(pos.xz);
+    if (clipmapStitch) {
+        vec2 edge = vec2(0.0);
+        if ((g.x == 0 || g.x == clipmapGrid) && (g.y & 1) == 1) edge = vec2(0.0, clipmapCellSize);
+        if ((g.y == 0 || g.y == clipmapGrid) && (g.x & 1) == 1) edge = vec2(clipmapCellSize, 0.0);
+        if (edge != vec2(0.0)) {
+            pos.y = 0.5 * (surfaceHeight(clampToPond(grid - edge)) + surfaceHeight(clampToPond(grid + edge)));
+        }
+    }
     
     gl_Position = projection * view * model * vec4(pos, 1.0);
-    TexCoords = aTexCoords;
+    
+    if (oceanEnabled) {
+        vec2 slope = textureLod(oceanMap, pos.xz / oceanPatchSize, 0.0).gb * oceanAmplitude;
+        Normal = normalize(vec3(-slope.x, 1.0, -slope.y));
+        return;
+    }
+    
+    if (bakedWaves) {
+        vec2 slope = sampleWaveAtlas(pos.xz).gb * waveAtlasRanges.y * waveStrength;
+        vec3 tangent = normalize(vec3(1.0, slope.x, 0.0));
+        vec3 bitangent = normalize(vec3(0.0, slope.y, 1.0));
+        Normal = normalize(cross(tangent, bitangent));
+        return;
+    }
     
     // 计算更精确的法线 - 基于所有波浪层的导数
     // X方向导数
@@ -2786,10 +6556,74 @@ in vec3 Normal;
 uniform sampler2D normalMap;
 uniform sampler2D dudvMap;
 uniform sampler2D reflectionMap;
+uniform bool planarReflection;           // reflectionMap 为镜像相机渲染的反射目标
+uniform mat4 reflectionViewProjection;   // 反射目标刷新时的镜像视图投影矩阵
 uniform vec3 viewPos;
 uniform float time;
 uniform float waterDepth;
 uniform float waveStrength;
+uniform sampler2D heightfield;
+uniform bool heightfieldEnabled;
+uniform float heightfieldScale;
+uniform float pondSize;
+uniform sampler2D oceanMap;
+uniform bool oceanEnabled;
+uniform float oceanPatchSize;
+uniform float oceanAmplitude;
+uniform sampler2DArray detailAtlas;  // 预烘焙的法线扰动（rg 为 x/z，归一化到 [0, 1]）
+uniform bool bakedWaves;
+uniform float waveAtlasTile;
+uniform vec3 waveAtlasRanges;
+uniform vec3 detailAtlasLayers;
+
+// 解析涟漪：每个涟漪两个纹素 (x, z, 半径, 脉动频率)、(颜色, 透明度)；分块 (起点, 数量) 指向涟漪编号
+uniform bool analyticRipples;
+uniform samplerBuffer rippleData;
+uniform isamplerBuffer rippleTiles;
+uniform isamplerBuffer rippleTileIndices;
+uniform int rippleTileResolution;
+uniform float rippleVisibility;
+
+// 与 ripple.vert/ripple.frag 的三层环纹相同的颜色（加法混合的 color * alpha），同时沿径向扰动法线
+vec3 shadeRipples(vec2 position, inout vec3 normal) {
+    vec2 tileCoord = clamp(floor((position / pondSize + 0.5) * float(rippleTileResolution)),
+                           vec2(0.0), vec2(float(rippleTileResolution - 1)));
+    ivec2 tile = texelFetch(rippleTiles, int(tileCoord.y) * rippleTileResolution + int(tileCoord.x)).xy;
+    vec3 light = vec3(0.0);
+    for (int k = 0; k < tile.y; k++) {
+        int index = texelFetch(rippleTileIndices, tile.x + k).x;
+        vec4 shape = texelFetch(rippleData, index * 2);
+        vec4 colorOpacity = texelFetch(rippleData, index * 2 + 1);
+        vec2 offset = position - shape.xy;
+        float radial = length(offset);
+        if (radial >= shape.z * 1.2) continue;
+        
+        for (int layer = 0; layer < 3; layer++) {
+            float dist = radial / (shape.z * (1.0 + float(layer) * 0.1));
+            if (dist >= 1.0) continue;
+            float layerIntensity = 1.0 - float(layer) * 0.3;
+            float colorPulse = 1.0 + 0.3 * sin(time * shape.w + float(layer));
+            vec3 rippleColor = min(colorOpacity.rgb * colorPulse * layerIntensity * rippleVisibility * 2.0, vec3(1.0));
+            float rippleOpacity = colorOpacity.a * layerIntensity * 0.8;
+            
+            float wavePattern = sin(dist * 25.0) * 0.8 + sin(dist * 50.0) * 0.3 + sin(dist * 100.0) * 0.1;
+            float edgeFade = smoothstep(0.85, 1.0, dist);
+            float innerFade = smoothstep(0.0, 0.15, dist);
+            float ringIntensity = smoothstep(0.2, 0.8, abs(sin(dist * 30.0)));
+            float intensity = (1.0 - edgeFade) * innerFade * (0.6 + ringIntensity * 0.4);
+            
+            vec3 color = rippleColor * (1.0 + wavePattern * 0.5) * intensity * 2.0;
+            float alpha = clamp(rippleOpacity * intensity * 1.5, 0.0, 1.0);
+            light += color * alpha;
+            
+            // 主环纹的径向斜率
+            if (layer == 0 && radial > 0.0) {
+                normal.xz += (offset / radial) * cos(dist * 25.0) * intensity * colorOpacity.a * 0.3;
+            }
+        }
+    }
+    return light;
+}
 
 void main() {
     // Enhanced distorted texture coordinates for better wave effects
@@ -2801,13 +6635,41 @@ void main() {
     // Generate enhanced dynamic normal
     vec3 normal = normalize(Normal);
     
-    // Multi-layer normal disturbance for more realistic water surface
-    normal.x += sin(TexCoords.x * 40.0 + time * 4.0) * sin(TexCoords.y * 30.0 + time * 3.0) * 0.04;
-    normal.z += cos(TexCoords.x * 35.0 + time * 3.5) * cos(TexCoords.y * 45.0 + time * 4.5) * 0.04;
+    if (oceanEnabled) {
+        // 海浪斜率逐像素采样（网格只承载位移）；再叠加一次缩小、旋转的采样作为细节，避免平铺重复
+        vec2 oceanUV = FragPos.xz / oceanPatchSize;
+        vec2 slope = texture(oceanMap, oceanUV).gb;
+        slope += texture(oceanMap, mat2(0.8, -0.6, 0.6, 0.8) * oceanUV * 3.7).gb * 0.3;
+        normal = normalize(vec3(-slope.x * oceanAmplitude, 1.0, -slope.y * oceanAmplitude));
+    } else if (bakedWaves) {
+        // 与下面的两层扰动相同，按时间在相邻两层之间插值
+        vec2 uv = FragPos.xz / waveAtlasTile;
+        vec2 first = texture(detailAtlas, vec3(uv, detailAtlasLayers.x)).rg;
+        vec2 second = texture(detailAtlas, vec3(uv, detailAtlasLayers.y)).rg;
+        normal.xz += (mix(first, second, detailAtlasLayers.z) * 2.0 - 1.0) * waveAtlasRanges.z;
+    } else {
+        // Multi-layer normal disturbance for more realistic water surface
+        normal.x += sin(TexCoords.x * 40.0 + time * 4.0) * sin(TexCoords.y * 30.0 + time * 3.0) * 0.04;
+        normal.z += cos(TexCoords.x * 35.0 + time * 3.5) * cos(TexCoords.y * 45.0 + time * 4.5) * 0.04;
+        
+        // Add fine detail ripples
+        normal.x += sin(TexCoords.x * 80.0 + time * 8.0) * sin(TexCoords.y * 70.0 + time * 7.0) * 0.01;
+        normal.z += cos(TexCoords.x * 75.0 + time * 7.5) * cos(TexCoords.y * 85.0 + time * 8.5) * 0.01;
+    }
+    
+    // 高度场法线：逐像素中心差分，水面网格比高度场粗，位移只体现大尺度起伏
+    if (heightfieldEnabled) {
+        vec2 uv = FragPos.xz / pondSize + 0.5;
+        vec2 texel = 1.0 / vec2(textureSize(heightfield, 0));
+        float dhdx = texture(heightfield, uv + vec2(texel.x, 0.0)).r - texture(heightfield, uv - vec2(texel.x, 0.0)).r;
+        float dhdz = texture(heightfield, uv + vec2(0.0, texel.y)).r - texture(heightfield, uv - vec2(0.0, texel.y)).r;
+        normal.xz -= vec2(dhdx, dhdz) * heightfieldScale / (2.0 * texel * pondSize);
+    }
     
-    // Add fine detail ripples
-    normal.x += sin(TexCoords.x * 80.0 + time * 8.0) * sin(TexCoords.y * 70.0 + time * 7.0) * 0.01;
-    normal.z += cos(TexCoords.x * 75.0 + time * 7.5) * cos(TexCoords.y * 85.0 + time * 8.5) * 0.01;
+    vec3 rippleLight = vec3(0.0);
+    if (analyticRipples) {
+        rippleLight = shadeRipples(FragPos.xz, normal);
+    }
     
     normal = normalize(normal);
     
@@ -2853,22 +6715,30 @@ void main() {
     
     // Enhanced reflection system
     float skyFresnel = pow(1.0 - max(dot(normal, viewDir), 0.0), 1.8);
-    vec3 skyColor = vec3(0.02, 0.05, 0.12);
-    
-    // Enhanced moonlight reflection
-    vec2 moonPos = vec2(0.75, 0.82);
-    float moonDist = distance(distortedTexCoords, moonPos);
-    vec3 moonColor = vec3(0.9, 0.9, 0.7) * smoothstep(0.2, 0.0, moonDist) * 1.2;
-    
-    // Enhanced star reflections
-    float stars = 0.0;
-    float starNoise = fract(sin(distortedTexCoords.x * 150.0) * sin(distortedTexCoords.y * 150.0) * 43758.5453);
-    if (starNoise > 0.995) {
-        stars = 0.6 + 0.4 * sin(time * 3.0 + distortedTexCoords.x * 15.0);
+    vec3 reflection;
+    if (planarReflection) {
+        // 水面点投影到反射目标（两次刷新之间用旧矩阵重投影），按法线扰动采样坐标
+        vec4 clip = reflectionViewProjection * vec4(FragPos, 1.0);
+        vec2 reflectionUV = clip.xy / max(clip.w, 1e-4) * 0.5 + 0.5 + normal.xz * 0.03;
+        reflection = texture(reflectionMap, clamp(reflectionUV, vec2(0.001), vec2(0.999))).rgb;
+    } else {
+        vec3 skyColor = vec3(0.02, 0.05, 0.12);
+        
+        // Enhanced moonlight reflection
+        vec2 moonPos = vec2(0.75, 0.82);
+        float moonDist = distance(distortedTexCoords, moonPos);
+        vec3 moonColor = vec3(0.9, 0.9, 0.7) * smoothstep(0.2, 0.0, moonDist) * 1.2;
+        
+        // Enhanced star reflections
+        float stars = 0.0;
+        float starNoise = fract(sin(distortedTexCoords.x * 150.0) * sin(distortedTexCoords.y * 150.0) * 43758.5453);
+        if (starNoise > 0.995) {
+            stars = 0.6 + 0.4 * sin(time * 3.0 + distortedTexCoords.x * 15.0);
+        }
+        
+        reflection = skyColor + moonColor + stars * vec3(0.9, 0.9, 1.0);
     }
     
-    vec3 reflection = skyColor + moonColor + stars * vec3(0.9, 0.9, 1.0);
-    
     // More sophisticated blending
     result = mix(result, reflection, skyFresnel * 0.6);
     result = mix(waterColor, result, 0.7);
@@ -2883,6 +6753,9 @@ void main() {
         result += vec3(0.3, 0.4, 0.5) * (waveHeight - 1.5) * 0.5;
     }
     
+    // 解析涟漪叠加在水面颜色上（与几何方式的加法混合一致）
+    result += rippleLight;
+    
     // Dynamic transparency
     float alpha = 0.85 + edgeHighlight * 0.15;
     
@@ -2890,8 +6763,8 @@ void main() {
 }
 )";
 
-    // Vertex shader - raindrop (enhanced)
-    const char* raindropVertexShader = R"(
+    // Vertex shader - point sprite (moon, stars)
+    const char* spriteVertexShader = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
@@ -2911,15 +6784,65 @@ void main() {
     Color = raindropColor;
     Brightness = brightness;
 }
+)";
+
+    // Vertex shader - raindrop (batched, one point per drop)
+    const char* raindropVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosLife;   // xyz 位置, w 存活时间
+layout (location = 1) in vec4 aAttrib;    // x 大小, y 闪烁速度, z 颜色下标
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform float time;
+uniform vec3 raindropColors[8];
+
+out vec3 Color;
+out float Brightness;
+
+void main() {
+    vec3 position = aPosLife.xyz;
+    float lifetime = aPosLife.w;
+    float size = aAttrib.x;
+    float twinkleSpeed = aAttrib.y;
+    
+    // Layer depth from camera distance
+    float distance = length(position - cameraPos);
+    float depth = min(distance / 200.0, 1.0);
+    
+    // Twinkling, brighter when near
+    float brightness = (0.7 + 0.3 * sin(lifetime * twinkleSpeed + position.x * 0.1)) * (1.2 - depth * 0.4);
+    
+    // Distance-based size, near drops are much larger
+    float finalSize = size * 100.0 / max(distance, 10.0);
+    if (depth < 0.3) {
+        finalSize *= 3.0;
+    } else if (depth < 0.6) {
+        finalSize *= 2.0;
+    }
+    
+    // Fluorescent glow
+    float glowEffect = 1.0 + 0.4 * sin(time * twinkleSpeed + position.x);
+    Color = raindropColors[int(aAttrib.z)] * brightness * glowEffect;
+    Brightness = brightness;
+    
+    gl_Position = projection * view * vec4(position, 1.0);
+    gl_PointSize = finalSize / gl_Position.w; // Size adjusted by distance
+}
 )";
 
     // Fragment shader - raindrop (enhanced with better glow effects)
     const char* raindropFragmentShader = R"(
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
 in vec3 Color;
 in float Brightness;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
 
 void main() {
     // Create circular point with improved gradient
@@ -2952,7 +6875,7 @@ void main() {
     // Boost brightness for better visibility
     finalColor = clamp(finalColor * 1.5, 0.0, 3.0);
     
-    FragColor = vec4(finalColor, alpha);
+    writeOutput(finalColor, alpha);
 }
 )";
 
@@ -2960,34 +6883,62 @@ void main() {
     const char* rippleVertexShader = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+// 实例属性（每个涟漪一条，三层共用）
+layout (location = 1) in vec4 aCenterRadius;  // xyz 中心，w 半径
+layout (location = 2) in vec4 aColorOpacity;  // rgb 颜色，a 透明度
+layout (location = 3) in vec4 aWave;          // x 波浪高度，y 脉动频率
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform float time;
+uniform float visibility;
 
-out vec3 FragPos;
+out vec2 LocalPos;
+flat out vec3 RippleColor;
+flat out float RippleOpacity;
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    float layer = float(gl_InstanceID % 3);
+    
+    // 每层略微不同的高度偏移、旋转和大小
+    float rotation = time * (0.1 + layer * 0.05);
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 rotated = vec2(c * aPos.x + s * aPos.z, -s * aPos.x + c * aPos.z);
+    float scale = aCenterRadius.w * (1.0 + layer * 0.1);
+    vec3 center = aCenterRadius.xyz;
+    center.y += aWave.x * sin(time * 2.0 + layer);
+    vec3 worldPos = center + vec3(rotated.x, 0.0, rotated.y) * scale;
+    
+    // 多层颜色效果：外层更暗，颜色随脉动频率起伏
+    float layerIntensity = 1.0 - layer * 0.3;
+    float colorPulse = 1.0 + 0.3 * sin(time * aWave.y + layer);
+    RippleColor = min(aColorOpacity.rgb * colorPulse * layerIntensity * visibility * 2.0, vec3(1.0));
+    RippleOpacity = aColorOpacity.a * layerIntensity * 0.8;
+    
+    // 环纹图案按网格局部坐标计算（单位圆内），与涟漪所在位置无关
+    LocalPos = aPos.xz;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
 }
 )";
 
     // Fragment shader - water ripple (enhanced with better visibility)
     const char* rippleFragmentShader = R"(
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
-in vec3 FragPos;
+in vec2 LocalPos;
+flat in vec3 RippleColor;
+flat in float RippleOpacity;
+
+uniform bool oitEnabled;
 
-uniform vec3 rippleColor;
-uniform float opacity;
+#include "oit_output.glsl"
 
 void main() {
     // Calculate ripple's radial position
-    vec3 center = vec3(0.0, 0.0, 0.0);
-    vec2 fromCenter = vec2(FragPos.x, FragPos.z);
-    float dist = length(fromCenter);
+    float dist = length(LocalPos);
     
     // Multi-frequency wave patterns for realistic ripple appearance
     float mainWave = sin(dist * 25.0) * 0.8;
@@ -2997,7 +6948,7 @@ void main() {
     float wavePattern = mainWave + detailWave + fineDetail;
     
     // Enhanced color with wave pattern
-    vec3 color = rippleColor * (1.0 + wavePattern * 0.5);
+    vec3 color = RippleColor * (1.0 + wavePattern * 0.5);
     
     // Improved edge handling for better visibility
     float edgeFade = smoothstep(0.85, 1.0, dist);
@@ -3009,12 +6960,12 @@ void main() {
     
     // Enhanced brightness for better visibility
     color *= intensity * 2.0;
-    float alpha = opacity * intensity;
+    float alpha = RippleOpacity * intensity;
     
     // Boost alpha for better visibility against water
     alpha = clamp(alpha * 1.5, 0.0, 1.0);
     
-    FragColor = vec4(color, alpha);
+    writeOutput(color, alpha);
 }
 )";
     
@@ -3036,6 +6987,10 @@ void main() {
     waterFrag.close();
     
     // Raindrop shaders
+    std::ofstream spriteVert("shaders/sprite.vert");
+    spriteVert << spriteVertexShader;
+    spriteVert.close();
+    
     std::ofstream raindropVert("shaders/raindrop.vert");
     raindropVert << raindropVertexShader;
     raindropVert.close();
@@ -3053,6 +7008,84 @@ void main() {
     rippleFrag << rippleFragmentShader;
     rippleFrag.close();
     
+    // 远处涟漪聚合场：每个格子一个水面四边形，环纹按世界坐标划分的小格随机生成，强度决定活跃比例
+    const char* rippleFieldVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aCell;   // xy 格子中心 (x, z)，z 半边长，w 强度
+layout (location = 1) in vec4 aColor;  // rgb 平均颜色
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float surfaceHeight;
+
+out vec2 WorldXZ;
+flat out vec3 FieldColor;
+flat out float Intensity;
+
+void main() {
+    // 三角带的四个角：(-1,-1) (1,-1) (-1,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    WorldXZ = aCell.xy + corner * aCell.z;
+    FieldColor = aColor.rgb;
+    Intensity = aCell.w;
+    gl_Position = projection * view * vec4(WorldXZ.x, surfaceHeight, WorldXZ.y, 1.0);
+}
+)";
+
+    const char* rippleFieldFragmentShader = R"(
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
+
+in vec2 WorldXZ;
+flat in vec3 FieldColor;
+flat in float Intensity;
+
+uniform float time;
+uniform float visibility;
+uniform bool oitEnabled;
+
+const float RING_CELL_SIZE = 6.0;  // 每个小格最多一个环（世界单位），相邻格子的图案连续
+
+#include "oit_output.glsl"
+
+float hash(vec2 p) {
+    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+}
+
+void main() {
+    vec2 uv = WorldXZ / RING_CELL_SIZE;
+    vec2 base = floor(uv);
+    
+    // 环可以越过小格边界，检查周围 3x3 个小格
+    float ring = 0.0;
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            vec2 cell = base + vec2(dx, dz);
+            float h = hash(cell);
+            if (h > Intensity) continue;
+            vec2 center = cell + 0.5 + (vec2(hash(cell + 17.0), hash(cell + 43.0)) - 0.5) * 0.6;
+            float phase = fract(time * (0.25 + 0.25 * hash(cell + 71.0)) + h * 7.0);
+            float radius = phase * 1.4;
+            float width = 0.06 + phase * 0.06;
+            ring += smoothstep(width, 0.0, abs(length(uv - center) - radius)) * (1.0 - phase);
+        }
+    }
+    
+    vec3 color = min(FieldColor * visibility * 2.0, vec3(1.0)) * ring;
+    float alpha = clamp(ring * 0.6, 0.0, 1.0);
+    writeOutput(color, alpha);
+}
+)";
+
+    std::ofstream rippleFieldVert("shaders/ripple_field.vert");
+    rippleFieldVert << rippleFieldVertexShader;
+    rippleFieldVert.close();
+    
+    std::ofstream rippleFieldFrag("shaders/ripple_field.frag");
+    rippleFieldFrag << rippleFieldFragmentShader;
+    rippleFieldFrag.close();
+    
     // Lightning shaders - 新增闪电着色器
     const char* lightningVertexShader = R"(
 #version 330 core
@@ -3069,10 +7102,14 @@ void main() {
 
     const char* lightningFragmentShader = R"(
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
 uniform vec3 lightningColor;
 uniform float intensity;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
 
 void main() {
     // 闪电发光效果
@@ -3085,7 +7122,7 @@ void main() {
     float flicker = 0.8 + 0.2 * fract(sin(gl_FragCoord.x * 12.9898 + gl_FragCoord.y * 78.233) * 43758.5453);
     finalColor *= flicker;
     
-    FragColor = vec4(finalColor, intensity);
+    writeOutput(finalColor, intensity);
 }
 )";
 
@@ -3098,6 +7135,453 @@ void main() {
     lightningFrag << lightningFragmentShader;
     lightningFrag.close();
 
+    // 雨滴拖尾着色器：GL_LINES 批量绘制，几何着色器按逐顶点宽度扩展为屏幕空间四边形
+    const char* trailVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosAlpha;   // xyz 位置, w 透明度
+layout (location = 1) in vec4 aColorWidth; // rgb 颜色, w 宽度（像素）
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec4 vColor;
+out float vWidth;
+
+void main() {
+    gl_Position = projection * view * vec4(aPosAlpha.xyz, 1.0);
+    vColor = vec4(aColorWidth.rgb, aPosAlpha.w);
+    vWidth = aColorWidth.w;
+}
+)";
+
+    const char* trailGeometryShader = R"(
+#version 330 core
+layout (lines) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in vec4 vColor[];
+in float vWidth[];
+
+uniform vec2 viewportSize;
+
+out vec4 gColor;
+out float gEdge;
+
+void main() {
+    vec4 p0 = gl_in[0].gl_Position;
+    vec4 p1 = gl_in[1].gl_Position;
+    
+    // 跳过落在相机后方的线段
+    if (p0.w <= 0.0 || p1.w <= 0.0) {
+        return;
+    }
+    
+    // 屏幕空间中线段的法线方向
+    vec2 halfViewport = viewportSize * 0.5;
+    vec2 direction = p1.xy / p1.w * halfViewport - p0.xy / p0.w * halfViewport;
+    if (dot(direction, direction) < 1e-6) {
+        direction = vec2(0.0, 1.0);
+    }
+    vec2 normal = normalize(vec2(-direction.y, direction.x));
+    
+    for (int i = 0; i < 2; i++) {
+        vec4 p = gl_in[i].gl_Position;
+        vec2 offset = normal * vWidth[i] * 0.5 / halfViewport * p.w;
+        for (int side = -1; side <= 1; side += 2) {
+            gl_Position = p + vec4(offset * float(side), 0.0, 0.0);
+            gColor = vColor[i];
+            gEdge = float(side);
+            EmitVertex();
+        }
+    }
+    EndPrimitive();
+}
+)";
+
+    const char* trailFragmentShader = R"(
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
+
+in vec4 gColor;
+in float gEdge;
+
+uniform float colorPulse;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
+
+void main() {
+    // 线段边缘柔化（代替 GL_LINE_SMOOTH）
+    float edge = 1.0 - smoothstep(0.5, 1.0, abs(gEdge));
+    
+    vec3 color = gColor.rgb * colorPulse;
+    writeOutput(color, gColor.a * edge);
+}
+)";
+
+    // Write raindrop trail shaders
+    std::ofstream trailVert("shaders/trail.vert");
+    trailVert << trailVertexShader;
+    trailVert.close();
+    
+    std::ofstream trailGeom("shaders/trail.geom");
+    trailGeom << trailGeometryShader;
+    trailGeom.close();
+    
+    std::ofstream trailFrag("shaders/trail.frag");
+    trailFrag << trailFragmentShader;
+    trailFrag.close();
+
+    // GPU雨滴模拟着色器（变换反馈）
+    // 状态缓冲每个雨滴 3 个 vec4：位置+存活时间、速度+寿命、大小/闪烁速度/颜色下标
+    // 寿命为 0 表示空槽（下一步生成），为 -1 表示上一步已落水（输出撞击后再生成）
+    const char* raindropSimVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+
+out vec4 outPosLife;
+out vec4 outVelSpan;
+out vec4 outAttrib;
+
+uniform float deltaTime;
+uniform vec3 cameraPos;
+uniform uint seed;
+uniform float waterHeight;
+uniform int colorCount;
+
+uint rngState;
+
+// 整数哈希（lowbias32），按雨滴下标和帧种子生成可复现的随机序列
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+float random01() {
+    rngState = hash(rngState);
+    return float(rngState >> 8) * (1.0 / 16777216.0);
+}
+
+// 与CPU端 generateRaindrops / RaindropPool::spawn 相同的分布
+void spawn() {
+    float cameraDistance = length(cameraPos);
+    float nearRadius = cameraDistance * 0.3;
+    float farRadius = cameraDistance * 1.5;
+    
+    float layerChoice = random01();
+    float radius, height;
+    if (layerChoice < 0.4) {
+        radius = nearRadius;
+        height = 15.0 + random01() * 25.0;
+    } else if (layerChoice < 0.7) {
+        radius = (nearRadius + farRadius) * 0.5;
+        height = 25.0 + random01() * 35.0;
+    } else {
+        radius = farRadius;
+        height = 35.0 + random01() * 50.0;
+    }
+    
+    float angle = random01() * 6.28318531;
+    float distance = random01() * radius;
+    vec3 position = cameraPos + vec3(distance * cos(angle), height, distance * sin(angle));
+    float depth = min(length(position - cameraPos) / 200.0, 1.0);
+    
+    vec3 velocity = vec3((random01() - 0.5) * 1.0, -3.0 - random01() * 5.0, (random01() - 0.5) * 1.0);
+    velocity.y *= 0.7 + depth * 0.6;
+    
+    float size = (2.0 - depth) * (1.0 + random01() * 2.0);
+    float lifespan = 4.0 + random01() * 4.0;
+    float twinkleSpeed = 1.0 + random01() * 5.0;
+    float colorIndex = float(min(int(random01() * float(colorCount)), colorCount - 1));
+    
+    outPosLife = vec4(position, 0.0);
+    outVelSpan = vec4(velocity, lifespan);
+    outAttrib = vec4(size, twinkleSpeed, colorIndex, 0.0);
+}
+
+void main() {
+    rngState = hash(uint(gl_VertexID) ^ hash(seed));
+    
+    if (aVelSpan.w <= 0.0) {
+        spawn();
+        return;
+    }
+    
+    float lifetime = aPosLife.w + deltaTime;
+    vec3 position = aPosLife.xyz;
+    vec3 velocity = aVelSpan.xyz;
+    float depth = min(length(position - cameraPos) / 200.0, 1.0);
+    
+    position += velocity * deltaTime;
+    
+    // 摆动与重力，与CPU积分核心一致
+    float swayAmount = 0.1 * (1.0 - depth);
+    velocity.x += (cos(lifetime * 3.0 + position.z) * swayAmount - velocity.x * 0.1) * deltaTime;
+    velocity.z += (sin(lifetime * 2.5 + position.x) * swayAmount - velocity.z * 0.1) * deltaTime;
+    velocity.y -= 2.0 * (0.8 + depth * 0.4) * deltaTime;
+    
+    if (position.y <= waterHeight) {
+        // 落水：保留撞击位置，标记后由撞击收集阶段输出
+        outPosLife = vec4(position, lifetime);
+        outVelSpan = vec4(velocity, -1.0);
+        outAttrib = aAttrib;
+    } else if (lifetime > aVelSpan.w) {
+        spawn();
+    } else {
+        outPosLife = vec4(position, lifetime);
+        outVelSpan = vec4(velocity, aVelSpan.w);
+        outAttrib = aAttrib;
+    }
+}
+)";
+
+    // 撞击收集：几何着色器只输出本步落水的雨滴（位置 + 颜色下标）
+    const char* raindropImpactVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+
+out vec4 vImpact;
+out float vLifespan;
+
+void main() {
+    vImpact = vec4(aPosLife.xyz, aAttrib.z);
+    vLifespan = aVelSpan.w;
+}
+)";
+
+    const char* raindropImpactGeometryShader = R"(
+#version 330 core
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in vec4 vImpact[];
+in float vLifespan[];
+
+out vec4 impact;
+
+void main() {
+    if (vLifespan[0] < 0.0) {
+        impact = vImpact[0];
+        EmitVertex();
+        EndPrimitive();
+    }
+}
+)";
+
+    // GPU雨滴渲染：直接读取模拟状态缓冲，大小和颜色计算与CPU路径一致
+    const char* raindropGpuVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+layout (location = 3) in vec4 aPrevPosLife; // 上一步的位置和存活时间
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform float time;
+uniform vec3 raindropColors[8];
+uniform float interpolation;  // 上一步到当前步的插值比例
+
+out vec3 Color;
+out float Brightness;
+
+void main() {
+    // 空槽和已落水的雨滴移出裁剪空间
+    if (aVelSpan.w <= 0.0) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        Color = vec3(0.0);
+        Brightness = 0.0;
+        return;
+    }
+    
+    // 存活时间增加说明两步之间是同一个雨滴，否则该槽位刚重新生成，直接用当前位置
+    vec3 position = aPosLife.xyz;
+    if (aPrevPosLife.w > 0.0 && aPosLife.w > aPrevPosLife.w) {
+        position = mix(aPrevPosLife.xyz, aPosLife.xyz, interpolation);
+    }
+    float lifetime = aPosLife.w;
+    float size = aAttrib.x;
+    float twinkleSpeed = aAttrib.y;
+    
+    float distance = length(position - cameraPos);
+    float depth = min(distance / 200.0, 1.0);
+    float brightness = (0.7 + 0.3 * sin(lifetime * twinkleSpeed + position.x * 0.1)) * (1.2 - depth * 0.4);
+    
+    // 基于距离的动态大小，近处雨滴明显更大
+    float finalSize = size * 100.0 / max(distance, 10.0);
+    if (depth < 0.3) {
+        finalSize *= 3.0;
+    } else if (depth < 0.6) {
+        finalSize *= 2.0;
+    }
+    
+    float glowEffect = 1.0 + 0.4 * sin(time * twinkleSpeed + position.x);
+    Color = raindropColors[int(aAttrib.z)] * brightness * glowEffect;
+    Brightness = brightness;
+    
+    gl_Position = projection * view * vec4(position, 1.0);
+    gl_PointSize = finalSize / gl_Position.w;
+}
+)";
+
+    // Write GPU raindrop shaders
+    std::ofstream raindropSimVert("shaders/raindrop_sim.vert");
+    raindropSimVert << raindropSimVertexShader;
+    raindropSimVert.close();
+    
+    std::ofstream raindropImpactVert("shaders/raindrop_impact.vert");
+    raindropImpactVert << raindropImpactVertexShader;
+    raindropImpactVert.close();
+    
+    std::ofstream raindropImpactGeom("shaders/raindrop_impact.geom");
+    raindropImpactGeom << raindropImpactGeometryShader;
+    raindropImpactGeom.close();
+    
+    std::ofstream raindropGpuVert("shaders/raindrop_gpu.vert");
+    raindropGpuVert << raindropGpuVertexShader;
+    raindropGpuVert.close();
+
+    // 顺序无关透明度合成着色器：全屏三角形，顶点位置由 gl_VertexID 生成
+    const char* oitResolveVertexShader = R"(
+#version 330 core
+out vec2 TexCoord;
+
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+    const char* oitResolveFragmentShader = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D accumTexture;     // 加权颜色和 + 加权透明度和
+uniform sampler2D revealageTexture; // 累加的 -log(1 - alpha)
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = exp(-texelFetch(revealageTexture, texel, 0).r);
+    if (revealage >= 0.999) discard; // 没有透明物体覆盖
+    
+    vec4 accum = texelFetch(accumTexture, texel, 0);
+    vec3 averageColor = accum.rgb / max(accum.a, 1e-5);
+    FragColor = vec4(averageColor, 1.0 - revealage);
+}
+)";
+
+    // 透明物体片元着色器共用的输出函数，由 Shader::readSource 展开 #include "oit_output.glsl"
+    // 包含前需声明 FragColor（location 0）、Revealage（location 1）和 uniform bool oitEnabled
+    const char* oitOutputShader = R"(
+// 加权混合顺序无关透明度（WBOIT）：oitEnabled 时输出累积颜色和 -log(1-alpha)，两者都用加法混合
+void writeOutput(vec3 color, float alpha) {
+    if (oitEnabled) {
+        alpha = clamp(alpha, 0.0, 0.999);
+        float viewDepth = 1.0 / gl_FragCoord.w;
+        float weight = clamp(10.0 / (1e-5 + pow(viewDepth / 5.0, 2.0) + pow(viewDepth / 200.0, 6.0)), 1e-2, 3e2);
+        FragColor = vec4(color * alpha, alpha) * weight;
+        Revealage = vec4(-log(1.0 - alpha));
+    } else {
+        FragColor = vec4(color, alpha);
+    }
+}
+)";
+
+    // Write OIT resolve shaders
+    std::ofstream oitOutput("shaders/oit_output.glsl");
+    oitOutput << oitOutputShader;
+    oitOutput.close();
+    
+    std::ofstream oitResolveVert("shaders/oit_resolve.vert");
+    oitResolveVert << oitResolveVertexShader;
+    oitResolveVert.close();
+    
+    std::ofstream oitResolveFrag("shaders/oit_resolve.frag");
+    oitResolveFrag << oitResolveFragmentShader;
+    oitResolveFrag.close();
+    
+    // 水面高度场：波动方程的一步显式差分（顶点着色器复用 oit_resolve.vert 的全屏三角形）
+    const char* waveSimFragmentShader = R"(
+#version 330 core
+layout (location = 0) out vec2 State;  // x 新高度，y 当前高度（下一步的上一步高度）
+
+uniform sampler2D state;               // x 当前高度，y 上一步高度
+uniform float courant2;                // (c·dt/dx)²，不超过 0.5 才稳定
+uniform float damping;                 // 每次迭代的振幅保留比例
+
+void main() {
+    ivec2 size = textureSize(state, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 center = texelFetch(state, texel, 0).xy;
+    
+    // 边界取相邻纹素（反射边界）
+    float left = texelFetch(state, clamp(texel - ivec2(1, 0), ivec2(0), size - 1), 0).x;
+    float right = texelFetch(state, clamp(texel + ivec2(1, 0), ivec2(0), size - 1), 0).x;
+    float down = texelFetch(state, clamp(texel - ivec2(0, 1), ivec2(0), size - 1), 0).x;
+    float up = texelFetch(state, clamp(texel + ivec2(0, 1), ivec2(0), size - 1), 0).x;
+    
+    float laplacian = left + right + down + up - 4.0 * center.x;
+    float height = (2.0 * center.x - center.y + courant2 * laplacian) * damping;
+    State = vec2(height, center.x * damping);
+}
+)";
+    
+    std::ofstream waveSimFrag("shaders/wave_sim.frag");
+    waveSimFrag << waveSimFragmentShader;
+    waveSimFrag.close();
+    
+    // 水面高度场撞击：每个撞击一个点精灵，覆盖高斯 3 倍半径内的纹素，加法混合写入新高度
+    const char* waveImpulseVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec4 aImpulse;  // xy 纹理坐标，z 强度，w 半径（纹理坐标）
+
+uniform float resolution;
+
+flat out vec4 Impulse;
+
+void main() {
+    Impulse = aImpulse;
+    gl_Position = vec4(aImpulse.xy * 2.0 - 1.0, 0.0, 1.0);
+    gl_PointSize = aImpulse.w * 6.0 * resolution;
+}
+)";
+
+    const char* waveImpulseFragmentShader = R"(
+#version 330 core
+layout (location = 0) out vec2 State;
+
+flat in vec4 Impulse;
+
+uniform float resolution;
+
+void main() {
+    // 高斯形状的下压，只改变新高度
+    vec2 offset = (gl_FragCoord.xy / resolution - Impulse.xy) / Impulse.w;
+    State = vec2(-Impulse.z * exp(-dot(offset, offset)), 0.0);
+}
+)";
+
+    std::ofstream waveImpulseVert("shaders/wave_impulse.vert");
+    waveImpulseVert << waveImpulseVertexShader;
+    waveImpulseVert.close();
+    
+    std::ofstream waveImpulseFrag("shaders/wave_impulse.frag");
+    waveImpulseFrag << waveImpulseFragmentShader;
+    waveImpulseFrag.close();
+
     // Create texture directory
     if (!file_exists("textures")) {
         create_directory("textures");
@@ -3117,6 +7601,26 @@ int main(int argc, char* argv[]) {
 #endif
 
     setConsoleCodePage();
+    
+    // 命令行参数
+    std::vector<std::string> args;
+#ifdef __WINDOWS__
+    std::istringstream cmdLine(lpCmdLine ? lpCmdLine : "");
+    for (std::string arg; cmdLine >> arg;) {
+        args.push_back(arg);
+    }
+#else
+    for (int i = 1; i < argc; i++) {
+        args.push_back(argv[i]);
+    }
+#endif
+    
+    // --bench：只运行雨滴积分微基准，不创建窗口
+    if (std::find(args.begin(), args.end(), "--bench") != args.end()) {
+        runIntegrationBenchmark();
+        return 0;
+    }
+    
     // 初始化SDL
     if (SDL_Init(SDL_INIT_AUDIO) < 0) {
         std::cerr << "SDL初始化失败: " << SDL_GetError() << std::endl;
@@ -3126,11 +7630,16 @@ int main(int argc, char* argv[]) {
     // 写入着色器文件
     writeShaderFiles();
     
-    // 设置随机种子
-    srand(static_cast<unsigned int>(time(nullptr)));
+    // 场景种子：--seed <n> 指定，否则取当前时间；打印出来以便重现同一场景
+    uint64_t sceneSeed = static_cast<uint64_t>(time(nullptr));
+    auto seedArg = std::find(args.begin(), args.end(), "--seed");
+    if (seedArg != args.end() && seedArg + 1 != args.end()) {
+        sceneSeed = std::strtoull((seedArg + 1)->c_str(), nullptr, 10);
+    }
+    std::cout << "场景种子: " << sceneSeed << std::endl;
     
     // 创建并运行模拟
-    RainSimulation simulation;
+    RainSimulation simulation(sceneSeed);
     if (simulation.init()) {
         simulation.run();
     }
@@ -1,9 +1,13 @@
 
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
 uniform vec3 lightningColor;
 uniform float intensity;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
 
 void main() {
     // 闪电发光效果
@@ -16,5 +20,5 @@ void main() {
     float flicker = 0.8 + 0.2 * fract(sin(gl_FragCoord.x * 12.9898 + gl_FragCoord.y * 78.233) * 43758.5453);
     finalColor *= flicker;
     
-    FragColor = vec4(finalColor, intensity);
+    writeOutput(finalColor, intensity);
 }
@@ -0,0 +1,13 @@
+
+// 加权混合顺序无关透明度（WBOIT）：oitEnabled 时输出累积颜色和 -log(1-alpha)，两者都用加法混合
+void writeOutput(vec3 color, float alpha) {
+    if (oitEnabled) {
+        alpha = clamp(alpha, 0.0, 0.999);
+        float viewDepth = 1.0 / gl_FragCoord.w;
+        float weight = clamp(10.0 / (1e-5 + pow(viewDepth / 5.0, 2.0) + pow(viewDepth / 200.0, 6.0)), 1e-2, 3e2);
+        FragColor = vec4(color * alpha, alpha) * weight;
+        Revealage = vec4(-log(1.0 - alpha));
+    } else {
+        FragColor = vec4(color, alpha);
+    }
+}
@@ -0,0 +1,17 @@
+
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D accumTexture;     // 加权颜色和 + 加权透明度和
+uniform sampler2D revealageTexture; // 累加的 -log(1 - alpha)
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = exp(-texelFetch(revealageTexture, texel, 0).r);
+    if (revealage >= 0.999) discard; // 没有透明物体覆盖
+    
+    vec4 accum = texelFetch(accumTexture, texel, 0);
+    vec3 averageColor = accum.rgb / max(accum.a, 1e-5);
+    FragColor = vec4(averageColor, 1.0 - revealage);
+}
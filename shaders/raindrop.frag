@@ -1,9 +1,13 @@
 
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
 in vec3 Color;
 in float Brightness;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
 
 void main() {
     // Create circular point with improved gradient
@@ -36,5 +40,5 @@ void main() {
     // Boost brightness for better visibility
     finalColor = clamp(finalColor * 1.5, 0.0, 3.0);
     
-    FragColor = vec4(finalColor, alpha);
+    writeOutput(finalColor, alpha);
 }
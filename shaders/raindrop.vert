@@ -1,20 +1,43 @@
 
 #version 330 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec4 aPosLife;   // xyz 位置, w 存活时间
+layout (location = 1) in vec4 aAttrib;    // x 大小, y 闪烁速度, z 颜色下标
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform float raindropSize;
-uniform vec3 raindropColor;
-uniform float brightness;
+uniform vec3 cameraPos;
+uniform float time;
+uniform vec3 raindropColors[8];
 
 out vec3 Color;
 out float Brightness;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    gl_PointSize = raindropSize / gl_Position.w; // Size adjusted by distance
-    Color = raindropColor;
+    vec3 position = aPosLife.xyz;
+    float lifetime = aPosLife.w;
+    float size = aAttrib.x;
+    float twinkleSpeed = aAttrib.y;
+    
+    // Layer depth from camera distance
+    float distance = length(position - cameraPos);
+    float depth = min(distance / 200.0, 1.0);
+    
+    // Twinkling, brighter when near
+    float brightness = (0.7 + 0.3 * sin(lifetime * twinkleSpeed + position.x * 0.1)) * (1.2 - depth * 0.4);
+    
+    // Distance-based size, near drops are much larger
+    float finalSize = size * 100.0 / max(distance, 10.0);
+    if (depth < 0.3) {
+        finalSize *= 3.0;
+    } else if (depth < 0.6) {
+        finalSize *= 2.0;
+    }
+    
+    // Fluorescent glow
+    float glowEffect = 1.0 + 0.4 * sin(time * twinkleSpeed + position.x);
+    Color = raindropColors[int(aAttrib.z)] * brightness * glowEffect;
     Brightness = brightness;
+    
+    gl_Position = projection * view * vec4(position, 1.0);
+    gl_PointSize = finalSize / gl_Position.w; // Size adjusted by distance
 }
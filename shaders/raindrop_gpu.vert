@@ -0,0 +1,55 @@
+
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+layout (location = 3) in vec4 aPrevPosLife; // 上一步的位置和存活时间
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform float time;
+uniform vec3 raindropColors[8];
+uniform float interpolation;  // 上一步到当前步的插值比例
+
+out vec3 Color;
+out float Brightness;
+
+void main() {
+    // 空槽和已落水的雨滴移出裁剪空间
+    if (aVelSpan.w <= 0.0) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        Color = vec3(0.0);
+        Brightness = 0.0;
+        return;
+    }
+    
+    // 存活时间增加说明两步之间是同一个雨滴，否则该槽位刚重新生成，直接用当前位置
+    vec3 position = aPosLife.xyz;
+    if (aPrevPosLife.w > 0.0 && aPosLife.w > aPrevPosLife.w) {
+        position = mix(aPrevPosLife.xyz, aPosLife.xyz, interpolation);
+    }
+    float lifetime = aPosLife.w;
+    float size = aAttrib.x;
+    float twinkleSpeed = aAttrib.y;
+    
+    float distance = length(position - cameraPos);
+    float depth = min(distance / 200.0, 1.0);
+    float brightness = (0.7 + 0.3 * sin(lifetime * twinkleSpeed + position.x * 0.1)) * (1.2 - depth * 0.4);
+    
+    // 基于距离的动态大小，近处雨滴明显更大
+    float finalSize = size * 100.0 / max(distance, 10.0);
+    if (depth < 0.3) {
+        finalSize *= 3.0;
+    } else if (depth < 0.6) {
+        finalSize *= 2.0;
+    }
+    
+    float glowEffect = 1.0 + 0.4 * sin(time * twinkleSpeed + position.x);
+    Color = raindropColors[int(aAttrib.z)] * brightness * glowEffect;
+    Brightness = brightness;
+    
+    gl_Position = projection * view * vec4(position, 1.0);
+    gl_PointSize = finalSize / gl_Position.w;
+}
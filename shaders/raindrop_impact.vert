@@ -0,0 +1,13 @@
+
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+
+out vec4 vImpact;
+out float vLifespan;
+
+void main() {
+    vImpact = vec4(aPosLife.xyz, aAttrib.z);
+    vLifespan = aVelSpan.w;
+}
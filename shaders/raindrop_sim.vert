@@ -0,0 +1,104 @@
+
+#version 330 core
+layout (location = 0) in vec4 aPosLife;
+layout (location = 1) in vec4 aVelSpan;
+layout (location = 2) in vec4 aAttrib;
+
+out vec4 outPosLife;
+out vec4 outVelSpan;
+out vec4 outAttrib;
+
+uniform float deltaTime;
+uniform vec3 cameraPos;
+uniform uint seed;
+uniform float waterHeight;
+uniform int colorCount;
+
+uint rngState;
+
+// 整数哈希（lowbias32），按雨滴下标和帧种子生成可复现的随机序列
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+float random01() {
+    rngState = hash(rngState);
+    return float(rngState >> 8) * (1.0 / 16777216.0);
+}
+
+// 与CPU端 generateRaindrops / RaindropPool::spawn 相同的分布
+void spawn() {
+    float cameraDistance = length(cameraPos);
+    float nearRadius = cameraDistance * 0.3;
+    float farRadius = cameraDistance * 1.5;
+    
+    float layerChoice = random01();
+    float radius, height;
+    if (layerChoice < 0.4) {
+        radius = nearRadius;
+        height = 15.0 + random01() * 25.0;
+    } else if (layerChoice < 0.7) {
+        radius = (nearRadius + farRadius) * 0.5;
+        height = 25.0 + random01() * 35.0;
+    } else {
+        radius = farRadius;
+        height = 35.0 + random01() * 50.0;
+    }
+    
+    float angle = random01() * 6.28318531;
+    float distance = random01() * radius;
+    vec3 position = cameraPos + vec3(distance * cos(angle), height, distance * sin(angle));
+    float depth = min(length(position - cameraPos) / 200.0, 1.0);
+    
+    vec3 velocity = vec3((random01() - 0.5) * 1.0, -3.0 - random01() * 5.0, (random01() - 0.5) * 1.0);
+    velocity.y *= 0.7 + depth * 0.6;
+    
+    float size = (2.0 - depth) * (1.0 + random01() * 2.0);
+    float lifespan = 4.0 + random01() * 4.0;
+    float twinkleSpeed = 1.0 + random01() * 5.0;
+    float colorIndex = float(min(int(random01() * float(colorCount)), colorCount - 1));
+    
+    outPosLife = vec4(position, 0.0);
+    outVelSpan = vec4(velocity, lifespan);
+    outAttrib = vec4(size, twinkleSpeed, colorIndex, 0.0);
+}
+
+void main() {
+    rngState = hash(uint(gl_VertexID) ^ hash(seed));
+    
+    if (aVelSpan.w <= 0.0) {
+        spawn();
+        return;
+    }
+    
+    float lifetime = aPosLife.w + deltaTime;
+    vec3 position = aPosLife.xyz;
+    vec3 velocity = aVelSpan.xyz;
+    float depth = min(length(position - cameraPos) / 200.0, 1.0);
+    
+    position += velocity * deltaTime;
+    
+    // 摆动与重力，与CPU积分核心一致
+    float swayAmount = 0.1 * (1.0 - depth);
+    velocity.x += (cos(lifetime * 3.0 + position.z) * swayAmount - velocity.x * 0.1) * deltaTime;
+    velocity.z += (sin(lifetime * 2.5 + position.x) * swayAmount - velocity.z * 0.1) * deltaTime;
+    velocity.y -= 2.0 * (0.8 + depth * 0.4) * deltaTime;
+    
+    if (position.y <= waterHeight) {
+        // 落水：保留撞击位置，标记后由撞击收集阶段输出
+        outPosLife = vec4(position, lifetime);
+        outVelSpan = vec4(velocity, -1.0);
+        outAttrib = aAttrib;
+    } else if (lifetime > aVelSpan.w) {
+        spawn();
+    } else {
+        outPosLife = vec4(position, lifetime);
+        outVelSpan = vec4(velocity, aVelSpan.w);
+        outAttrib = aAttrib;
+    }
+}
@@ -1,17 +1,19 @@
 
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
 
-in vec3 FragPos;
+in vec2 LocalPos;
+flat in vec3 RippleColor;
+flat in float RippleOpacity;
 
-uniform vec3 rippleColor;
-uniform float opacity;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
 
 void main() {
     // Calculate ripple's radial position
-    vec3 center = vec3(0.0, 0.0, 0.0);
-    vec2 fromCenter = vec2(FragPos.x, FragPos.z);
-    float dist = length(fromCenter);
+    float dist = length(LocalPos);
     
     // Multi-frequency wave patterns for realistic ripple appearance
     float mainWave = sin(dist * 25.0) * 0.8;
@@ -21,7 +23,7 @@ void main() {
     float wavePattern = mainWave + detailWave + fineDetail;
     
     // Enhanced color with wave pattern
-    vec3 color = rippleColor * (1.0 + wavePattern * 0.5);
+    vec3 color = RippleColor * (1.0 + wavePattern * 0.5);
     
     // Improved edge handling for better visibility
     float edgeFade = smoothstep(0.85, 1.0, dist);
@@ -33,10 +35,10 @@ void main() {
     
     // Enhanced brightness for better visibility
     color *= intensity * 2.0;
-    float alpha = opacity * intensity;
+    float alpha = RippleOpacity * intensity;
     
     // Boost alpha for better visibility against water
     alpha = clamp(alpha * 1.5, 0.0, 1.0);
     
-    FragColor = vec4(color, alpha);
+    writeOutput(color, alpha);
 }
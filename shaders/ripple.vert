@@ -1,14 +1,40 @@
 
 #version 330 core
 layout (location = 0) in vec3 aPos;
+// 实例属性（每个涟漪一条，三层共用）
+layout (location = 1) in vec4 aCenterRadius;  // xyz 中心，w 半径
+layout (location = 2) in vec4 aColorOpacity;  // rgb 颜色，a 透明度
+layout (location = 3) in vec4 aWave;          // x 波浪高度，y 脉动频率
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform float time;
+uniform float visibility;
 
-out vec3 FragPos;
+out vec2 LocalPos;
+flat out vec3 RippleColor;
+flat out float RippleOpacity;
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    float layer = float(gl_InstanceID % 3);
+    
+    // 每层略微不同的高度偏移、旋转和大小
+    float rotation = time * (0.1 + layer * 0.05);
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 rotated = vec2(c * aPos.x + s * aPos.z, -s * aPos.x + c * aPos.z);
+    float scale = aCenterRadius.w * (1.0 + layer * 0.1);
+    vec3 center = aCenterRadius.xyz;
+    center.y += aWave.x * sin(time * 2.0 + layer);
+    vec3 worldPos = center + vec3(rotated.x, 0.0, rotated.y) * scale;
+    
+    // 多层颜色效果：外层更暗，颜色随脉动频率起伏
+    float layerIntensity = 1.0 - layer * 0.3;
+    float colorPulse = 1.0 + 0.3 * sin(time * aWave.y + layer);
+    RippleColor = min(aColorOpacity.rgb * colorPulse * layerIntensity * visibility * 2.0, vec3(1.0));
+    RippleOpacity = aColorOpacity.a * layerIntensity * 0.8;
+    
+    // 环纹图案按网格局部坐标计算（单位圆内），与涟漪所在位置无关
+    LocalPos = aPos.xz;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
 }
@@ -0,0 +1,44 @@
+
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
+
+in vec2 WorldXZ;
+flat in vec3 FieldColor;
+flat in float Intensity;
+
+uniform float time;
+uniform float visibility;
+uniform bool oitEnabled;
+
+const float RING_CELL_SIZE = 6.0;  // 每个小格最多一个环（世界单位），相邻格子的图案连续
+
+#include "oit_output.glsl"
+
+float hash(vec2 p) {
+    return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
+}
+
+void main() {
+    vec2 uv = WorldXZ / RING_CELL_SIZE;
+    vec2 base = floor(uv);
+    
+    // 环可以越过小格边界，检查周围 3x3 个小格
+    float ring = 0.0;
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            vec2 cell = base + vec2(dx, dz);
+            float h = hash(cell);
+            if (h > Intensity) continue;
+            vec2 center = cell + 0.5 + (vec2(hash(cell + 17.0), hash(cell + 43.0)) - 0.5) * 0.6;
+            float phase = fract(time * (0.25 + 0.25 * hash(cell + 71.0)) + h * 7.0);
+            float radius = phase * 1.4;
+            float width = 0.06 + phase * 0.06;
+            ring += smoothstep(width, 0.0, abs(length(uv - center) - radius)) * (1.0 - phase);
+        }
+    }
+    
+    vec3 color = min(FieldColor * visibility * 2.0, vec3(1.0)) * ring;
+    float alpha = clamp(ring * 0.6, 0.0, 1.0);
+    writeOutput(color, alpha);
+}
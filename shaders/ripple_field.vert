@@ -0,0 +1,21 @@
+
+#version 330 core
+layout (location = 0) in vec4 aCell;   // xy 格子中心 (x, z)，z 半边长，w 强度
+layout (location = 1) in vec4 aColor;  // rgb 平均颜色
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float surfaceHeight;
+
+out vec2 WorldXZ;
+flat out vec3 FieldColor;
+flat out float Intensity;
+
+void main() {
+    // 三角带的四个角：(-1,-1) (1,-1) (-1,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    WorldXZ = aCell.xy + corner * aCell.z;
+    FieldColor = aColor.rgb;
+    Intensity = aCell.w;
+    gl_Position = projection * view * vec4(WorldXZ.x, surfaceHeight, WorldXZ.y, 1.0);
+}
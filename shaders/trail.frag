@@ -0,0 +1,20 @@
+
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 Revealage;
+
+in vec4 gColor;
+in float gEdge;
+
+uniform float colorPulse;
+uniform bool oitEnabled;
+
+#include "oit_output.glsl"
+
+void main() {
+    // 线段边缘柔化（代替 GL_LINE_SMOOTH）
+    float edge = 1.0 - smoothstep(0.5, 1.0, abs(gEdge));
+    
+    vec3 color = gColor.rgb * colorPulse;
+    writeOutput(color, gColor.a * edge);
+}
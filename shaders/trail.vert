@@ -0,0 +1,16 @@
+
+#version 330 core
+layout (location = 0) in vec4 aPosAlpha;   // xyz 位置, w 透明度
+layout (location = 1) in vec4 aColorWidth; // rgb 颜色, w 宽度（像素）
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec4 vColor;
+out float vWidth;
+
+void main() {
+    gl_Position = projection * view * vec4(aPosAlpha.xyz, 1.0);
+    vColor = vec4(aColorWidth.rgb, aPosAlpha.w);
+    vWidth = aColorWidth.w;
+}
@@ -9,10 +9,74 @@ in vec3 Normal;
 uniform sampler2D normalMap;
 uniform sampler2D dudvMap;
 uniform sampler2D reflectionMap;
+uniform bool planarReflection;           // reflectionMap 为镜像相机渲染的反射目标
+uniform mat4 reflectionViewProjection;   // 反射目标刷新时的镜像视图投影矩阵
 uniform vec3 viewPos;
 uniform float time;
 uniform float waterDepth;
 uniform float waveStrength;
+uniform sampler2D heightfield;
+uniform bool heightfieldEnabled;
+uniform float heightfieldScale;
+uniform float pondSize;
+uniform sampler2D oceanMap;
+uniform bool oceanEnabled;
+uniform float oceanPatchSize;
+uniform float oceanAmplitude;
+uniform sampler2DArray detailAtlas;  // 预烘焙的法线扰动（rg 为 x/z，归一化到 [0, 1]）
+uniform bool bakedWaves;
+uniform float waveAtlasTile;
+uniform vec3 waveAtlasRanges;
+uniform vec3 detailAtlasLayers;
+
+// 解析涟漪：每个涟漪两个纹素 (x, z, 半径, 脉动频率)、(颜色, 透明度)；分块 (起点, 数量) 指向涟漪编号
+uniform bool analyticRipples;
+uniform samplerBuffer rippleData;
+uniform isamplerBuffer rippleTiles;
+uniform isamplerBuffer rippleTileIndices;
+uniform int rippleTileResolution;
+uniform float rippleVisibility;
+
+// 与 ripple.vert/ripple.frag 的三层环纹相同的颜色（加法混合的 color * alpha），同时沿径向扰动法线
+vec3 shadeRipples(vec2 position, inout vec3 normal) {
+    vec2 tileCoord = clamp(floor((position / pondSize + 0.5) * float(rippleTileResolution)),
+                           vec2(0.0), vec2(float(rippleTileResolution - 1)));
+    ivec2 tile = texelFetch(rippleTiles, int(tileCoord.y) * rippleTileResolution + int(tileCoord.x)).xy;
+    vec3 light = vec3(0.0);
+    for (int k = 0; k < tile.y; k++) {
+        int index = texelFetch(rippleTileIndices, tile.x + k).x;
+        vec4 shape = texelFetch(rippleData, index * 2);
+        vec4 colorOpacity = texelFetch(rippleData, index * 2 + 1);
+        vec2 offset = position - shape.xy;
+        float radial = length(offset);
+        if (radial >= shape.z * 1.2) continue;
+        
+        for (int layer = 0; layer < 3; layer++) {
+            float dist = radial / (shape.z * (1.0 + float(layer) * 0.1));
+            if (dist >= 1.0) continue;
+            float layerIntensity = 1.0 - float(layer) * 0.3;
+            float colorPulse = 1.0 + 0.3 * sin(time * shape.w + float(layer));
+            vec3 rippleColor = min(colorOpacity.rgb * colorPulse * layerIntensity * rippleVisibility * 2.0, vec3(1.0));
+            float rippleOpacity = colorOpacity.a * layerIntensity * 0.8;
+            
+            float wavePattern = sin(dist * 25.0) * 0.8 + sin(dist * 50.0) * 0.3 + sin(dist * 100.0) * 0.1;
+            float edgeFade = smoothstep(0.85, 1.0, dist);
+            float innerFade = smoothstep(0.0, 0.15, dist);
+            float ringIntensity = smoothstep(0.2, 0.8, abs(sin(dist * 30.0)));
+            float intensity = (1.0 - edgeFade) * innerFade * (0.6 + ringIntensity * 0.4);
+            
+            vec3 color = rippleColor * (1.0 + wavePattern * 0.5) * intensity * 2.0;
+            float alpha = clamp(rippleOpacity * intensity * 1.5, 0.0, 1.0);
+            light += color * alpha;
+            
+            // 主环纹的径向斜率
+            if (layer == 0 && radial > 0.0) {
+                normal.xz += (offset / radial) * cos(dist * 25.0) * intensity * colorOpacity.a * 0.3;
+            }
+        }
+    }
+    return light;
+}
 
 void main() {
     // Enhanced distorted texture coordinates for better wave effects
@@ -24,13 +88,41 @@ void main() {
     // Generate enhanced dynamic normal
     vec3 normal = normalize(Normal);
     
-    // Multi-layer normal disturbance for more realistic water surface
-    normal.x += sin(TexCoords.x * 40.0 + time * 4.0) * sin(TexCoords.y * 30.0 + time * 3.0) * 0.04;
-    normal.z += cos(TexCoords.x * 35.0 + time * 3.5) * cos(TexCoords.y * 45.0 + time * 4.5) * 0.04;
+    if (oceanEnabled) {
+        // 海浪斜率逐像素采样（网格只承载位移）；再叠加一次缩小、旋转的采样作为细节，避免平铺重复
+        vec2 oceanUV = FragPos.xz / oceanPatchSize;
+        vec2 slope = texture(oceanMap, oceanUV).gb;
+        slope += texture(oceanMap, mat2(0.8, -0.6, 0.6, 0.8) * oceanUV * 3.7).gb * 0.3;
+        normal = normalize(vec3(-slope.x * oceanAmplitude, 1.0, -slope.y * oceanAmplitude));
+    } else if (bakedWaves) {
+        // 与下面的两层扰动相同，按时间在相邻两层之间插值
+        vec2 uv = FragPos.xz / waveAtlasTile;
+        vec2 first = texture(detailAtlas, vec3(uv, detailAtlasLayers.x)).rg;
+        vec2 second = texture(detailAtlas, vec3(uv, detailAtlasLayers.y)).rg;
+        normal.xz += (mix(first, second, detailAtlasLayers.z) * 2.0 - 1.0) * waveAtlasRanges.z;
+    } else {
+        // Multi-layer normal disturbance for more realistic water surface
+        normal.x += sin(TexCoords.x * 40.0 + time * 4.0) * sin(TexCoords.y * 30.0 + time * 3.0) * 0.04;
+        normal.z += cos(TexCoords.x * 35.0 + time * 3.5) * cos(TexCoords.y * 45.0 + time * 4.5) * 0.04;
+        
+        // Add fine detail ripples
+        normal.x += sin(TexCoords.x * 80.0 + time * 8.0) * sin(TexCoords.y * 70.0 + time * 7.0) * 0.01;
+        normal.z += cos(TexCoords.x * 75.0 + time * 7.5) * cos(TexCoords.y * 85.0 + time * 8.5) * 0.01;
+    }
     
-    // Add fine detail ripples
-    normal.x += sin(TexCoords.x * 80.0 + time * 8.0) * sin(TexCoords.y * 70.0 + time * 7.0) * 0.01;
-    normal.z += cos(TexCoords.x * 75.0 + time * 7.5) * cos(TexCoords.y * 85.0 + time * 8.5) * 0.01;
+    // 高度场法线：逐像素中心差分，水面网格比高度场粗，位移只体现大尺度起伏
+    if (heightfieldEnabled) {
+        vec2 uv = FragPos.xz / pondSize + 0.5;
+        vec2 texel = 1.0 / vec2(textureSize(heightfield, 0));
+        float dhdx = texture(heightfield, uv + vec2(texel.x, 0.0)).r - texture(heightfield, uv - vec2(texel.x, 0.0)).r;
+        float dhdz = texture(heightfield, uv + vec2(0.0, texel.y)).r - texture(heightfield, uv - vec2(0.0, texel.y)).r;
+        normal.xz -= vec2(dhdx, dhdz) * heightfieldScale / (2.0 * texel * pondSize);
+    }
+    
+    vec3 rippleLight = vec3(0.0);
+    if (analyticRipples) {
+        rippleLight = shadeRipples(FragPos.xz, normal);
+    }
     
     normal = normalize(normal);
     
@@ -76,22 +168,30 @@ void main() {
     
     // Enhanced reflection system
     float skyFresnel = pow(1.0 - max(dot(normal, viewDir), 0.0), 1.8);
-    vec3 skyColor = vec3(0.02, 0.05, 0.12);
-    
-    // Enhanced moonlight reflection
-    vec2 moonPos = vec2(0.75, 0.82);
-    float moonDist = distance(distortedTexCoords, moonPos);
-    vec3 moonColor = vec3(0.9, 0.9, 0.7) * smoothstep(0.2, 0.0, moonDist) * 1.2;
-    
-    // Enhanced star reflections
-    float stars = 0.0;
-    float starNoise = fract(sin(distortedTexCoords.x * 150.0) * sin(distortedTexCoords.y * 150.0) * 43758.5453);
-    if (starNoise > 0.995) {
-        stars = 0.6 + 0.4 * sin(time * 3.0 + distortedTexCoords.x * 15.0);
+    vec3 reflection;
+    if (planarReflection) {
+        // 水面点投影到反射目标（两次刷新之间用旧矩阵重投影），按法线扰动采样坐标
+        vec4 clip = reflectionViewProjection * vec4(FragPos, 1.0);
+        vec2 reflectionUV = clip.xy / max(clip.w, 1e-4) * 0.5 + 0.5 + normal.xz * 0.03;
+        reflection = texture(reflectionMap, clamp(reflectionUV, vec2(0.001), vec2(0.999))).rgb;
+    } else {
+        vec3 skyColor = vec3(0.02, 0.05, 0.12);
+        
+        // Enhanced moonlight reflection
+        vec2 moonPos = vec2(0.75, 0.82);
+        float moonDist = distance(distortedTexCoords, moonPos);
+        vec3 moonColor = vec3(0.9, 0.9, 0.7) * smoothstep(0.2, 0.0, moonDist) * 1.2;
+        
+        // Enhanced star reflections
+        float stars = 0.0;
+        float starNoise = fract(sin(distortedTexCoords.x * 150.0) * sin(distortedTexCoords.y * 150.0) * 43758.5453);
+        if (starNoise > 0.995) {
+            stars = 0.6 + 0.4 * sin(time * 3.0 + distortedTexCoords.x * 15.0);
+        }
+        
+        reflection = skyColor + moonColor + stars * vec3(0.9, 0.9, 1.0);
     }
     
-    vec3 reflection = skyColor + moonColor + stars * vec3(0.9, 0.9, 1.0);
-    
     // More sophisticated blending
     result = mix(result, reflection, skyFresnel * 0.6);
     result = mix(waterColor, result, 0.7);
@@ -106,6 +206,9 @@ void main() {
         result += vec3(0.3, 0.4, 0.5) * (waveHeight - 1.5) * 0.5;
     }
     
+    // 解析涟漪叠加在水面颜色上（与几何方式的加法混合一致）
+    result += rippleLight;
+    
     // Dynamic transparency
     float alpha = 0.85 + edgeHighlight * 0.15;
     
@@ -1,7 +1,6 @@
 
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoords;
+// 水面网格为以相机为中心的嵌套网格（clipmap），顶点位置由 gl_VertexID 和本层的原点、格距得到，不需要顶点属性
 
 out vec2 TexCoords;
 out vec3 FragPos;
@@ -13,32 +12,112 @@ uniform mat4 projection;
 uniform float time;
 uniform float waveStrength;
 uniform float waveSpeed;
+uniform sampler2D heightfield;      // 雨滴撞击的波动方程高度场（r 为高度）
+uniform bool heightfieldEnabled;
+uniform float heightfieldScale;
+uniform float pondSize;
+uniform vec2 clipmapOrigin;         // 本层中心（世界 xz）
+uniform float clipmapCellSize;      // 本层格距
+uniform int clipmapGrid;            // 每层每边的格数
+uniform bool clipmapStitch;         // 外边与更粗的一层相接
+uniform sampler2D oceanMap;         // FFT 海浪（r 高度，g/b 为 x/z 斜率），按波块边长平铺
+uniform bool oceanEnabled;
+uniform float oceanPatchSize;
+uniform float oceanAmplitude;
+uniform sampler2DArray waveAtlas;   // 预烘焙的叠加正弦波（r 高度，g/b 为 x/z 斜率，单位波浪强度，归一化到 [0, 1]）
+uniform bool bakedWaves;
+uniform float waveAtlasTile;        // 图集平铺边长
+uniform vec3 waveAtlasRanges;       // 高度、斜率、片元扰动的取值范围
+uniform vec3 waveAtlasLayers;       // 当前时刻的相邻两层和插值系数
 
-void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+// 相邻两层之间按时间插值，解码为 [-1, 1]
+vec4 sampleWaveAtlas(vec2 p) {
+    vec2 uv = p / waveAtlasTile;
+    vec4 first = textureLod(waveAtlas, vec3(uv, waveAtlasLayers.x), 0.0);
+    vec4 second = textureLod(waveAtlas, vec3(uv, waveAtlasLayers.y), 0.0);
+    return mix(first, second, waveAtlasLayers.z) * 2.0 - 1.0;
+}
+
+// 多层复杂波浪效果 - 增加更多层次
+float surfaceHeight(vec2 p) {
+    if (oceanEnabled) {
+        float height = textureLod(oceanMap, p / oceanPatchSize, 0.0).r * oceanAmplitude;
+        if (heightfieldEnabled) {
+            height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+        }
+        return height;
+    }
     
-    // 多层复杂波浪效果 - 增加更多层次
-    vec3 pos = aPos;
+    if (bakedWaves) {
+        float height = sampleWaveAtlas(p).r * waveAtlasRanges.x * waveStrength;
+        if (heightfieldEnabled) {
+            height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+        }
+        return height;
+    }
     
     // 第一层：大波浪
-    float wave1 = sin(pos.x * 0.08 + time * waveSpeed) * cos(pos.z * 0.08 + time * waveSpeed * 0.8) * waveStrength;
+    float wave1 = sin(p.x * 0.08 + time * waveSpeed) * cos(p.y * 0.08 + time * waveSpeed * 0.8) * waveStrength;
     
     // 第二层：中等波浪
-    float wave2 = sin(pos.x * 0.15 + time * waveSpeed * 1.3) * cos(pos.z * 0.12 + time * waveSpeed * 1.1) * waveStrength * 0.6;
+    float wave2 = sin(p.x * 0.15 + time * waveSpeed * 1.3) * cos(p.y * 0.12 + time * waveSpeed * 1.1) * waveStrength * 0.6;
     
     // 第三层：小波浪
-    float wave3 = sin(pos.x * 0.25 + time * waveSpeed * 1.8) * cos(pos.z * 0.22 + time * waveSpeed * 1.5) * waveStrength * 0.3;
+    float wave3 = sin(p.x * 0.25 + time * waveSpeed * 1.8) * cos(p.y * 0.22 + time * waveSpeed * 1.5) * waveStrength * 0.3;
     
     // 第四层：微波
-    float wave4 = sin(pos.x * 0.4 + time * waveSpeed * 2.2) * cos(pos.z * 0.35 + time * waveSpeed * 2.0) * waveStrength * 0.15;
+    float wave4 = sin(p.x * 0.4 + time * waveSpeed * 2.2) * cos(p.y * 0.35 + time * waveSpeed * 2.0) * waveStrength * 0.15;
     
     // 第五层：细微波纹
-    float wave5 = sin(pos.x * 0.6 + time * waveSpeed * 2.8) * cos(pos.z * 0.55 + time * waveSpeed * 2.5) * waveStrength * 0.08;
+    float wave5 = sin(p.x * 0.6 + time * waveSpeed * 2.8) * cos(p.y * 0.55 + time * waveSpeed * 2.5) * waveStrength * 0.08;
+    
+    float height = wave1 + wave2 + wave3 + wave4 + wave5;
+    if (heightfieldEnabled) {
+        height += texture(heightfield, p / pondSize + 0.5).r * heightfieldScale;
+    }
+    return height;
+}
+
+vec2 clampToPond(vec2 p) {
+    return clamp(p, vec2(-0.5 * pondSize), vec2(0.5 * pondSize));
+}
+
+void main() {
+    int side = clipmapGrid + 1;
+    ivec2 g = ivec2(gl_VertexID % side, gl_VertexID / side);
+    vec2 grid = clipmapOrigin + vec2(g - ivec2(clipmapGrid / 2)) * clipmapCellSize;
     
-    pos.y = wave1 + wave2 + wave3 + wave4 + wave5;
+    // 池塘外的顶点压到边界上（三角形退化，不产生可见面积）
+    vec3 pos = vec3(clampToPond(grid), 0.0).xzy;
+    FragPos = vec3(model * vec4(pos, 1.0));
+    TexCoords = pos.xz / pondSize + 0.5;
+    
+    // 接缝：外边上的奇数顶点不在粗一层的网格上，高度取两侧偶数顶点的平均，与粗一层的边完全重合
+    pos.y = surfaceHeight(pos.xz);
+    if (clipmapStitch) {
+        vec2 edge = vec2(0.0);
+        if ((g.x == 0 || g.x == clipmapGrid) && (g.y & 1) == 1) edge = vec2(0.0, clipmapCellSize);
+        if ((g.y == 0 || g.y == clipmapGrid) && (g.x & 1) == 1) edge = vec2(clipmapCellSize, 0.0);
+        if (edge != vec2(0.0)) {
+            pos.y = 0.5 * (surfaceHeight(clampToPond(grid - edge)) + surfaceHeight(clampToPond(grid + edge)));
+        }
+    }
     
     gl_Position = projection * view * model * vec4(pos, 1.0);
-    TexCoords = aTexCoords;
+    
+    if (oceanEnabled) {
+        vec2 slope = textureLod(oceanMap, pos.xz / oceanPatchSize, 0.0).gb * oceanAmplitude;
+        Normal = normalize(vec3(-slope.x, 1.0, -slope.y));
+        return;
+    }
+    
+    if (bakedWaves) {
+        vec2 slope = sampleWaveAtlas(pos.xz).gb * waveAtlasRanges.y * waveStrength;
+        vec3 tangent = normalize(vec3(1.0, slope.x, 0.0));
+        vec3 bitangent = normalize(vec3(0.0, slope.y, 1.0));
+        Normal = normalize(cross(tangent, bitangent));
+        return;
+    }
     
     // 计算更精确的法线 - 基于所有波浪层的导数
     // X方向导数
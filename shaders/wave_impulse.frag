@@ -0,0 +1,13 @@
+
+#version 330 core
+layout (location = 0) out vec2 State;
+
+flat in vec4 Impulse;
+
+uniform float resolution;
+
+void main() {
+    // 高斯形状的下压，只改变新高度
+    vec2 offset = (gl_FragCoord.xy / resolution - Impulse.xy) / Impulse.w;
+    State = vec2(-Impulse.z * exp(-dot(offset, offset)), 0.0);
+}
@@ -0,0 +1,13 @@
+
+#version 330 core
+layout (location = 0) in vec4 aImpulse;  // xy 纹理坐标，z 强度，w 半径（纹理坐标）
+
+uniform float resolution;
+
+flat out vec4 Impulse;
+
+void main() {
+    Impulse = aImpulse;
+    gl_Position = vec4(aImpulse.xy * 2.0 - 1.0, 0.0, 1.0);
+    gl_PointSize = aImpulse.w * 6.0 * resolution;
+}
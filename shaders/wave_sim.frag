@@ -0,0 +1,23 @@
+
+#version 330 core
+layout (location = 0) out vec2 State;  // x 新高度，y 当前高度（下一步的上一步高度）
+
+uniform sampler2D state;               // x 当前高度，y 上一步高度
+uniform float courant2;                // (c·dt/dx)²，不超过 0.5 才稳定
+uniform float damping;                 // 每次迭代的振幅保留比例
+
+void main() {
+    ivec2 size = textureSize(state, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec2 center = texelFetch(state, texel, 0).xy;
+    
+    // 边界取相邻纹素（反射边界）
+    float left = texelFetch(state, clamp(texel - ivec2(1, 0), ivec2(0), size - 1), 0).x;
+    float right = texelFetch(state, clamp(texel + ivec2(1, 0), ivec2(0), size - 1), 0).x;
+    float down = texelFetch(state, clamp(texel - ivec2(0, 1), ivec2(0), size - 1), 0).x;
+    float up = texelFetch(state, clamp(texel + ivec2(0, 1), ivec2(0), size - 1), 0).x;
+    
+    float laplacian = left + right + down + up - 4.0 * center.x;
+    float height = (2.0 * center.x - center.y + courant2 * laplacian) * damping;
+    State = vec2(height, center.x * damping);
+}